@@ -1,4 +1,11 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <string>
 #include <vector>
 #include <list>
 
@@ -134,12 +141,393 @@ void zipExamples() {
     std::cout << std::endl << std::endl;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// tqdm examples
+////////////////////////////////////////////////////////////////////////////////
+void tqdmExamples() {
+    std::cout << "tqdm" << std::endl;
+    std::vector<int> vec(1000000, 1);
+
+    // Progress of an enumerate, the bar is drawn on stderr
+    int64_t sum = 0;
+    for (auto&& [index, value] : tqdm{ enumerate{ vec }, "enumerate" }) {
+        sum += index * value;
+    }
+
+    // Several threads can report to one shared bar
+    progress_bar bar{ 2000000, "shared" };
+    for (int64_t i : tqdm{ range(1000000), bar }) { sum += i; }
+    for (int64_t i : tqdm{ range(1000000, 2000000), bar }) { sum -= i; }
+    std::cout << "Should print -500000500000" << std::endl << "             " << sum << std::endl << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// sort examples
+////////////////////////////////////////////////////////////////////////////////
+void sortExamples() {
+    std::cout << "sort" << std::endl;
+
+    // Radix sort a key column with a 12 byte payload column, which doesn't fill whole
+    // cache lines, so every row must still match its key afterwards
+    std::vector<uint32_t> keys(100000);
+    std::vector<std::array<int32_t, 3>> payloads(keys.size());
+    for (uint32_t i = 0; i < keys.size(); ++i) {
+        keys[i] = i * 2654435761u;
+        payloads[i] = { static_cast<int32_t>(keys[i]), static_cast<int32_t>(i), -static_cast<int32_t>(keys[i]) };
+    }
+    radix_sort(zip{ keys, payloads });
+    int64_t mismatched = 0;
+    for (auto&& [key, payload] : zip{ keys, payloads }) {
+        mismatched += payload[0] != static_cast<int32_t>(key) || payload[2] != -static_cast<int32_t>(key);
+    }
+    std::cout << "Should print 0 1" << std::endl << "             " << mismatched << " " << std::is_sorted(keys.begin(), keys.end()) << std::endl;
+
+    // -0.0 and 0.0 compare equal, so a stable sort keeps them in their order
+    std::cout << "Should print (0)(2)(1)(3)(4)(5)" << std::endl << "             ";
+    for (int64_t index : argsort(std::vector<double>{ 3, 1, 2, 1, -0.0, 0.0 }, true)) {
+        std::cout << "(" << index << ")";
+    }
+    std::cout << std::endl << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// set operation examples
+////////////////////////////////////////////////////////////////////////////////
+void setOperationExamples() {
+    std::cout << "set operations" << std::endl;
+    std::vector<uint32_t> evens{ 0,2,4,6,8 };
+    std::vector<uint32_t> threes{ 0,3,6,9 };
+
+    // Sorted, duplicate free inputs
+    std::cout << "Should print (0)(6) (0)(2)(3)(4)(6)(8)(9) (2)(4)(8)" << std::endl << "             ";
+    for (uint32_t value : intersect(evens, threes)) {
+        std::cout << "(" << value << ")";
+    }
+    std::cout << " ";
+    for (uint32_t value : unite(evens, threes)) {
+        std::cout << "(" << value << ")";
+    }
+    std::cout << " ";
+    for (uint32_t value : difference(evens, threes)) {
+        std::cout << "(" << value << ")";
+    }
+    std::cout << std::endl << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// unique examples
+////////////////////////////////////////////////////////////////////////////////
+void uniqueExamples() {
+    std::cout << "unique" << std::endl;
+
+    // The first of every run of equal elements
+    std::vector<int> sorted_vec{ 1,1,2,3,3,3,4 };
+    std::cout << "Should print (1)(2)(3)(4)" << std::endl << "             ";
+    for (int value : unique{ sorted_vec }) {
+        std::cout << "(" << value << ")";
+    }
+    std::cout << std::endl;
+
+    // Elements whose key wasn't seen before, in any order
+    std::vector<int> vec{ 5,1,5,2,1,7 };
+    std::cout << "Should print (5)(1)(2)(7)" << std::endl << "             ";
+    for (int value : unique_everseen{ vec }) {
+        std::cout << "(" << value << ")";
+    }
+    std::cout << std::endl;
+
+    // With a key function
+    std::cout << "Should print (5)(2)" << std::endl << "             ";
+    for (int value : unique_everseen{ vec, [](int value) { return value % 2; } }) {
+        std::cout << "(" << value << ")";
+    }
+    std::cout << std::endl << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// tee examples
+////////////////////////////////////////////////////////////////////////////////
+void teeExamples() {
+    std::cout << "tee" << std::endl;
+
+    // Two branches over one generator, the first consumed before the second
+    tee branches{ range(3), 2 };
+    std::cout << "Should print (0)(1)(2)(0)(1)(2)" << std::endl << "             ";
+    for (int64_t value : branches[0]) {
+        std::cout << "(" << value << ")";
+    }
+    for (int64_t value : branches[1]) {
+        std::cout << "(" << value << ")";
+    }
+    std::cout << std::endl;
+
+    // Every consumer on its own thread
+    int64_t count = 0;
+    int64_t sum = 0;
+    parallel_tee(range(1000),
+                 [&](auto& values) { for (int64_t value : values) { ++count; (void)value; } },
+                 [&](auto& values) { for (int64_t value : values) { sum += value; } });
+    std::cout << "Should print 1000 499500" << std::endl << "             " << count << " " << sum << std::endl << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// zip_longest examples
+////////////////////////////////////////////////////////////////////////////////
+void zipLongestExamples() {
+    std::cout << "zip_longest" << std::endl;
+    std::vector<int> vec1{ 1,2,3 };
+    std::vector<int> vec2{ 4 };
+
+    // The shorter iterable is filled up with the fill value
+    std::cout << "Should print (1,4)(2,0)(3,0)" << std::endl << "             ";
+    for (auto&& [vec1_val, vec2_val] : zip_longest{ 0, vec1, vec2 }) {
+        std::cout << "(" << vec1_val << "," << vec2_val << ")";
+    }
+    std::cout << std::endl << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// reversed examples
+////////////////////////////////////////////////////////////////////////////////
+void reversedExamples() {
+    std::cout << "reversed" << std::endl;
+    std::vector<int> vec1{ 1,2,3 };
+    std::vector<int> vec2{ 4,5 };
+
+    // A range with the reversed bounds
+    std::cout << "Should print (8)(5)(2)" << std::endl << "             ";
+    for (int64_t value : reversed(range(2, 11, 3))) {
+        std::cout << "(" << value << ")";
+    }
+    std::cout << std::endl;
+
+    // Indices count down
+    std::cout << "Should print (2,3)(1,2)(0,1)" << std::endl << "             ";
+    for (auto&& [index, value] : reversed(enumerate{ vec1 })) {
+        std::cout << "(" << index << "," << value << ")";
+    }
+    std::cout << std::endl;
+
+    // The rows zip yields, last one first
+    std::cout << "Should print (2,5)(1,4)" << std::endl << "             ";
+    for (auto&& [vec1_val, vec2_val] : reversed(zip{ vec1, vec2 })) {
+        std::cout << "(" << vec1_val << "," << vec2_val << ")";
+    }
+    std::cout << std::endl << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// roundrobin examples
+////////////////////////////////////////////////////////////////////////////////
+void roundrobinExamples() {
+    std::cout << "roundrobin" << std::endl;
+    std::vector<int> vec1{ 1,2,3 };
+    std::vector<int> vec2{ 4 };
+    std::vector<int> vec3{ 5,6 };
+
+    // Exhausted iterables are skipped
+    std::cout << "Should print (1)(4)(5)(2)(6)(3)" << std::endl << "             ";
+    for (int value : roundrobin{ vec1, vec2, vec3 }) {
+        std::cout << "(" << value << ")";
+    }
+    std::cout << std::endl;
+
+    // interleave yields only complete rounds, it stops once one iterable is exhausted
+    std::cout << "Should print (1)(5)(2)(6)" << std::endl << "             ";
+    for (int value : interleave{ vec1, vec3 }) {
+        std::cout << "(" << value << ")";
+    }
+    std::cout << std::endl << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// batched examples
+////////////////////////////////////////////////////////////////////////////////
+void batchedExamples() {
+    std::cout << "batched" << std::endl;
+    std::vector<int> vec{ 1,2,3,4,5 };
+
+    // Spans over contiguous storage, the last one partial
+    std::cout << "Should print (1,2)(3,4)(5)p" << std::endl << "             ";
+    for (auto&& batch : batched(vec, 2)) {
+        std::cout << "(";
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            std::cout << (i > 0 ? "," : "") << batch[i];
+        }
+        std::cout << ")" << (batch.partial() ? "p" : "");
+    }
+    std::cout << std::endl;
+
+    // Generators are copied into one reused buffer
+    std::cout << "Should print (0,1,2)(3,4,5)(6)" << std::endl << "             ";
+    for (auto&& batch : batched(range(7), 3)) {
+        std::cout << "(";
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            std::cout << (i > 0 ? "," : "") << batch[i];
+        }
+        std::cout << ")";
+    }
+    std::cout << std::endl;
+
+    // Batches of contiguous storage spread over threads
+    std::vector<int64_t> squares(1000);
+    for (auto&& [index, value] : enumerate{ squares }) {
+        value = index;
+    }
+    parallel_for_each(batched(squares, 64), [](auto batch) {
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            batch[i] *= batch[i];
+        }
+    });
+    std::cout << "Should print 998001" << std::endl << "             " << squares.back() << std::endl << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// arena examples
+////////////////////////////////////////////////////////////////////////////////
+void arenaExamples() {
+    std::cout << "arena" << std::endl;
+    arena scratch;
+
+    // Everything allocated in a scope is released when it ends, the chunks are kept
+    std::size_t reserved = 0;
+    int64_t sum = 0;
+    for (int64_t i : range(3)) {
+        arena_scope scope{ scratch };
+        std::vector<int64_t, arena_allocator<int64_t>> values{ arena_allocator<int64_t>{ scratch } };
+        for (int64_t value : range(100)) {
+            values.push_back(value * i);
+        }
+        sum += values.back();
+        if (i == 0) {
+            reserved = scratch.reserved_bytes();
+        }
+    }
+    std::cout << "Should print 297 1" << std::endl << "             " << sum << " " << (scratch.reserved_bytes() == reserved) << std::endl << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// list examples
+////////////////////////////////////////////////////////////////////////////////
+void listExamples() {
+    std::cout << "list" << std::endl;
+
+    // Appending, extending from a generator and popping the front
+    list<int> values{ 1,2,3 };
+    values.append(4);
+    values.extend(range(5, 8));
+    int first = values.pop(0);
+    std::cout << "Should print 1 (2)(3)(4)(5)(6)(7)" << std::endl << "             " << first << " ";
+    for (int value : values) {
+        std::cout << "(" << value << ")";
+    }
+    std::cout << std::endl << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// intern examples
+////////////////////////////////////////////////////////////////////////////////
+void internExamples() {
+    std::cout << "intern" << std::endl;
+
+    // Equal strings give the same handle, comparing pointers
+    std::string built = std::string("time") + "stamp";
+    interned field = intern("timestamp");
+    std::cout << "Should print timestamp 1 0" << std::endl << "             "
+              << field << " " << (field == intern(built)) << " " << (field == intern("value")) << std::endl;
+
+    // A whole batch at once
+    std::vector<std::string> names{ "a", "b", "a" };
+    list<interned> handles = intern(names);
+    std::cout << "Should print (a)(b)(a) 1" << std::endl << "             ";
+    for (const interned& handle : handles) {
+        std::cout << "(" << handle << ")";
+    }
+    std::cout << " " << (handles[0].id() == handles[2].id()) << std::endl << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// str examples
+////////////////////////////////////////////////////////////////////////////////
+void strExamples() {
+    std::cout << "str" << std::endl;
+
+    // Counting the fields of a line in a hash map keyed on str
+    str line = "b,a,b,c";
+    std::map<str, int> counts;
+    for (const str& field : line.split(",")) {
+        ++counts[field];
+    }
+    std::cout << "Should print (a,1)(b,2)(c,1)" << std::endl << "             ";
+    for (auto&& [field, count] : counts) {
+        std::cout << "(" << field << "," << count << ")";
+    }
+    std::cout << std::endl;
+
+    // Slices with negative indices like Python
+    std::cout << "Should print b,c" << std::endl << "             " << line.slice(-3) << std::endl << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// walk examples
+////////////////////////////////////////////////////////////////////////////////
+void walkExamples() {
+    std::cout << "walk" << std::endl;
+    const std::filesystem::path root = std::filesystem::temp_directory_path() / "utilities_walk_example";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root / "sub");
+    std::ofstream(root / "a.txt");
+    std::ofstream(root / "sub" / "b.txt");
+
+    // The directories of a tree, top down
+    std::cout << "Should print (sub:a.txt)(:b.txt)" << std::endl << "             ";
+    for (auto&& [dirpath, dirnames, filenames] : walk(root.string())) {
+        std::cout << "(";
+        for (const str& name : dirnames) {
+            std::cout << name;
+        }
+        std::cout << ":";
+        for (const str& name : filenames) {
+            std::cout << name;
+        }
+        std::cout << ")";
+    }
+    std::cout << std::endl;
+
+    // The entries of one directory, in no particular order
+    std::vector<std::string> names;
+    for (auto&& entry : scandir(root.string())) {
+        names.push_back(std::string(entry.name()) + (entry.is_dir() ? "/" : ""));
+    }
+    std::sort(names.begin(), names.end());
+    std::cout << "Should print (a.txt)(sub/)" << std::endl << "             ";
+    for (const std::string& name : names) {
+        std::cout << "(" << name << ")";
+    }
+    std::cout << std::endl << std::endl;
+    std::filesystem::remove_all(root);
+}
+
 int main() {
     std::cout << "Beginning examples:" << std::endl << std::endl;
 
     rangeExamples();
     enumerateExamples();
     zipExamples();
+    tqdmExamples();
+    sortExamples();
+    setOperationExamples();
+    uniqueExamples();
+    teeExamples();
+    zipLongestExamples();
+    reversedExamples();
+    roundrobinExamples();
+    batchedExamples();
+    arenaExamples();
+    listExamples();
+    internExamples();
+    strExamples();
+    walkExamples();
 
     return 0;
 }
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#define UTILITIES_ARENA_HAS_MMAP 1
+#endif
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // ArenaChunk - The header at the start of every block of memory an arena hands
+    // out from. Chunks form a list in the order they are used, chunks past the
+    // current one are kept after a rewind to be used again.
+    ////////////////////////////////////////////////////////////////////////////////
+    struct ArenaChunk {
+        ArenaChunk* next;
+        std::size_t bytes;
+        bool mapped;
+
+        char* first() { return reinterpret_cast<char*>(this) + sizeof(ArenaChunk); }
+        char* last() { return reinterpret_cast<char*>(this) + bytes; }
+    };
+
+    constexpr std::size_t kHugePageBytes = std::size_t(2) << 20;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // allocate_chunk - A chunk of at least bytes. With huge pages the size is rounded
+    // up to whole 2 MiB pages, which are taken from the reserved huge pages if there
+    // are any and otherwise asked for as transparent huge pages. Everything else, or
+    // where mmap isn't available, comes from operator new.
+    ////////////////////////////////////////////////////////////////////////////////
+    inline ArenaChunk* allocate_chunk(std::size_t bytes, bool huge_pages) {
+        void* memory = nullptr;
+        bool mapped = false;
+#if defined(UTILITIES_ARENA_HAS_MMAP)
+        if (huge_pages) {
+            bytes = (bytes + kHugePageBytes - 1) / kHugePageBytes * kHugePageBytes;
+#if defined(MAP_HUGETLB)
+            memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#else
+            memory = MAP_FAILED;
+#endif
+            if (memory == MAP_FAILED) {
+                memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (memory == MAP_FAILED) { throw std::bad_alloc(); }
+#if defined(MADV_HUGEPAGE)
+                madvise(memory, bytes, MADV_HUGEPAGE);
+#endif
+            }
+            mapped = true;
+        }
+#endif
+        if (!mapped) { memory = ::operator new(bytes); }
+        return new (memory) ArenaChunk{nullptr, bytes, mapped};
+    }
+
+    inline void free_chunk(ArenaChunk* chunk) {
+#if defined(UTILITIES_ARENA_HAS_MMAP)
+        if (chunk->mapped) {
+            munmap(chunk, chunk->bytes);
+            return;
+        }
+#endif
+        ::operator delete(chunk);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Arena - The bump allocator behind arena. It lives here rather than with the
+    // public names so that other internals shared by all translation units, like
+    // the string interner, can hold one.
+    ////////////////////////////////////////////////////////////////////////////////
+    class Arena {
+    public:
+        //------------------------------------------------------------------------------
+        // marker - A position in the arena to rewind to
+        //------------------------------------------------------------------------------
+        struct marker {
+            ArenaChunk* chunk;
+            char* position;
+        };
+
+        //------------------------------------------------------------------------------
+        // Constructors - chunk_bytes is the size of the blocks taken from the system,
+        // huge_pages backs them with 2 MiB pages where the system supports it
+        //------------------------------------------------------------------------------
+        explicit Arena(std::size_t chunk_bytes = std::size_t(1) << 20, bool huge_pages = false)
+            : chunk_bytes_(std::max(chunk_bytes, 2 * sizeof(ArenaChunk)))
+            , huge_pages_(huge_pages)
+        {
+            // Nothing
+        }
+
+        ~Arena() {
+            while (first_ != nullptr) {
+                ArenaChunk* next = first_->next;
+                free_chunk(first_);
+                first_ = next;
+            }
+        }
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        //------------------------------------------------------------------------------
+        // allocate - bytes aligned to alignment, a power of two. The memory stays valid
+        // until the arena is rewound past it.
+        //------------------------------------------------------------------------------
+        void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) {
+            char* aligned = align(position_, alignment);
+            if (position_ == nullptr || aligned + bytes > limit_) { aligned = next_chunk(bytes, alignment); }
+            position_ = aligned + bytes;
+            return aligned;
+        }
+
+        // An array of count default initialized T, which must not need destruction
+        template<class T>
+        T* allocate_array(std::size_t count) {
+            static_assert(std::is_trivially_destructible_v<T>, "the arena doesn't run destructors");
+            return new (allocate(count * sizeof(T), alignof(T))) T[count];
+        }
+
+        // A T constructed from args, which must not need destruction
+        template<class T, class... Args>
+        T* make(Args&&... args) {
+            static_assert(std::is_trivially_destructible_v<T>, "the arena doesn't run destructors");
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        //------------------------------------------------------------------------------
+        // mark, rewind and reset - Release everything allocated since a mark, or since
+        // the arena was created, in O(1)
+        //------------------------------------------------------------------------------
+        marker mark() const { return {current_, position_}; }
+
+        void rewind(const marker& to) {
+            current_ = to.chunk;
+            position_ = to.position;
+            limit_ = current_ != nullptr ? current_->last() : nullptr;
+        }
+
+        void reset() { rewind({first_, first_ != nullptr ? first_->first() : nullptr}); }
+
+        //------------------------------------------------------------------------------
+        // release - Frees the chunks past the current one, kept for reuse otherwise
+        //------------------------------------------------------------------------------
+        void release() {
+            ArenaChunk*& spare = current_ != nullptr ? current_->next : first_;
+            while (spare != nullptr) {
+                ArenaChunk* next = spare->next;
+                reserved_bytes_ -= spare->bytes;
+                free_chunk(spare);
+                spare = next;
+            }
+        }
+
+        // The bytes of all chunks held, in use or not
+        std::size_t reserved_bytes() const { return reserved_bytes_; }
+
+    private:
+        static char* align(char* position, std::size_t alignment) {
+            const auto address = reinterpret_cast<std::uintptr_t>(position);
+            return reinterpret_cast<char*>((address + alignment - 1) & ~(std::uintptr_t(alignment) - 1));
+        }
+
+        // Moves on to the next kept chunk if the allocation fits, to a new one otherwise
+        char* next_chunk(std::size_t bytes, std::size_t alignment) {
+            ArenaChunk* next = current_ != nullptr ? current_->next : first_;
+            if (next == nullptr || align(next->first(), alignment) + bytes > next->last()) {
+                const std::size_t needed = sizeof(ArenaChunk) + alignment + bytes;
+                ArenaChunk* chunk = allocate_chunk(std::max(chunk_bytes_, needed), huge_pages_);
+                reserved_bytes_ += chunk->bytes;
+                chunk->next = next;
+                (current_ != nullptr ? current_->next : first_) = chunk;
+                next = chunk;
+            }
+            current_ = next;
+            limit_ = current_->last();
+            return align(current_->first(), alignment);
+        }
+
+        const std::size_t chunk_bytes_;
+        const bool huge_pages_;
+        ArenaChunk* first_ = nullptr;
+        ArenaChunk* current_ = nullptr;
+        char* position_ = nullptr;
+        char* limit_ = nullptr;
+        std::size_t reserved_bytes_ = 0;
+    };
+
+}
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // arena - A bump allocator. Allocating moves a pointer through the current
+    // chunk, freeing single allocations does nothing, and everything allocated since
+    // a mark is released at once and in O(1) by rewinding to it. The chunks stay
+    // with the arena to be used again, so a loop that rewinds once per iteration
+    // stops touching the heap after its first iterations.
+    //      arena scratch;
+    //      for (auto&& request : requests) {
+    //          arena_scope scope{ scratch };
+    //          std::vector<int, arena_allocator<int>> ids{ arena_allocator<int>{ scratch } };
+    //          ...
+    //      }
+    // Nothing allocated with it has its destructor run by the arena, containers
+    // using arena_allocator destroy their own elements as usual.
+    ////////////////////////////////////////////////////////////////////////////////
+    using arena = utilities::intern::Arena;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // arena_scope - Rewinds an arena to where it was when the scope began
+    ////////////////////////////////////////////////////////////////////////////////
+    class arena_scope {
+    public:
+        explicit arena_scope(arena& scratch) : arena_(scratch), marker_(scratch.mark()) { }
+        ~arena_scope() { arena_.rewind(marker_); }
+
+        arena_scope(const arena_scope&) = delete;
+        arena_scope& operator=(const arena_scope&) = delete;
+
+    private:
+        arena& arena_;
+        const arena::marker marker_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // arena_allocator - A standard allocator taking memory from an arena, for the
+    // temporary containers of a loop body. Deallocation does nothing, the memory
+    // comes back when the arena is rewound.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class T>
+    class arena_allocator {
+    public:
+        using value_type = T;
+
+        explicit arena_allocator(arena& scratch) : arena_(&scratch) { }
+
+        template<class U>
+        arena_allocator(const arena_allocator<U>& other) : arena_(other.source()) { }
+
+        T* allocate(std::size_t count) { return static_cast<T*>(arena_->allocate(count * sizeof(T), alignof(T))); }
+        void deallocate(T*, std::size_t) { }
+
+        arena* source() const { return arena_; }
+
+        template<class U>
+        bool operator==(const arena_allocator<U>& other) const { return arena_ == other.source(); }
+        template<class U>
+        bool operator!=(const arena_allocator<U>& other) const { return arena_ != other.source(); }
+
+    private:
+        arena* arena_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // thread_arena - An arena per thread, for scratch memory in parallel loops
+    // without sharing one arena between threads
+    //      parallel_for_each(batched(samples, 4096), [](auto batch) {
+    //          arena_scope scope{ thread_arena() };
+    //          ...
+    //      });
+    ////////////////////////////////////////////////////////////////////////////////
+    inline arena& thread_arena() {
+        thread_local arena scratch;
+        return scratch;
+    }
+}
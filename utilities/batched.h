@@ -0,0 +1,318 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "generator_iterator.h"
+#include "parallel.h"
+#include "range.h"
+#include "span.h"
+#include "zip.h"
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // BatchSource - Where the elements of batches come from. Contiguous storage is
+    // viewed in place, and its batches can also be reached by index. Elements of
+    // anything else are copied into one buffer that every batch reuses.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable, class Element = typename ContiguousElement<Iterable>::type>
+    class BatchSource {
+    public:
+        using Value = Element;
+        static constexpr bool kContiguous = true;
+
+        explicit BatchSource(Iterable& iterable)
+            : first_(std::data(iterable))
+            , position_(first_)
+            , last_(first_ + std::size(iterable))
+        {
+            // Nothing
+        }
+
+        // The next up to count elements
+        Span<Element> take(int64_t count) {
+            const Span<Element> batch = at(position_ - first_, count);
+            position_ += batch.size();
+            return batch;
+        }
+
+        // Up to count elements starting at offset
+        Span<Element> at(int64_t offset, int64_t count) const {
+            return Span<Element>(first_ + offset, static_cast<std::size_t>(std::min(count, size() - offset)));
+        }
+
+        int64_t size() const { return last_ - first_; }
+
+    private:
+        Element* first_;
+        Element* position_;
+        Element* last_;
+    };
+
+    template<class Iterable>
+    class BatchSource<Iterable, void> {
+    public:
+        using Value = decltype(materialize(*std::begin(std::declval<Iterable&>())));
+        static constexpr bool kContiguous = false;
+
+        explicit BatchSource(Iterable& iterable)
+            : iterator_(std::begin(iterable))
+            , end_(std::end(iterable))
+        {
+            // Nothing
+        }
+
+        // The next up to count elements, assigned over the previous batch's
+        Span<Value> take(int64_t count) {
+            std::size_t size = 0;
+            for (; static_cast<int64_t>(size) < count && iterator_ != end_; ++iterator_, ++size) {
+                if (size < buffer_.size()) {
+                    buffer_[size] = materialize(*iterator_);
+                } else {
+                    buffer_.push_back(materialize(*iterator_));
+                }
+            }
+            return Span<Value>(buffer_.data(), size);
+        }
+
+    private:
+        decltype(std::begin(std::declval<Iterable&>())) iterator_;
+        decltype(std::end(std::declval<Iterable&>())) end_;
+        std::vector<Value> buffer_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Batch - A span over one batch. partial() tells the last batch apart when it
+    // is shorter than the others.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class T>
+    struct Batch : Span<T> {
+        constexpr bool partial() const { return partial_; }
+
+        bool partial_ = false;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ZipBatch - One batch of zipped iterables, a span per iterable, all of the same
+    // size. Supports structured bindings.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class... Ts>
+    struct ZipBatch {
+        constexpr std::size_t size() const { return std::get<0>(spans_).size(); }
+        constexpr bool partial() const { return partial_; }
+
+        // Enables structured bindings
+        template <std::size_t N>
+        constexpr const auto& get() const { return std::get<N>(spans_); }
+
+        std::tuple<Span<Ts>...> spans_;
+        bool partial_ = false;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // BatchedState - This represents the state of a batched, the current batch and
+    // where the next one comes from. Zipped iterables are cut to the shortest.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class... Iterables>
+    struct BatchedState {
+        using Sources = std::tuple<BatchSource<std::remove_reference_t<Iterables>>...>;
+        using Values = std::tuple<typename BatchSource<std::remove_reference_t<Iterables>>::Value...>;
+        using Current = std::conditional_t<sizeof...(Iterables) == 1,
+                                           Batch<std::tuple_element_t<0, Values>>,
+                                           ZipBatch<typename BatchSource<std::remove_reference_t<Iterables>>::Value...>>;
+        static constexpr bool kRandomAccess = (BatchSource<std::remove_reference_t<Iterables>>::kContiguous && ...);
+
+        // Construct from the batched iterables and the batch size
+        BatchedState(std::tuple<Iterables...>& iterables, int64_t size)
+            : BatchedState(iterables, size, std::index_sequence_for<Iterables...>{})
+        {
+            // Nothing
+        }
+
+        // Takes the next batch from every source
+        void operator++() {
+            std::apply([&](auto&... sources) { current_ = make_batch(sources.take(size_)...); }, sources_);
+        }
+        constexpr bool can_advance() const { return current_.size() > 0; }
+
+        // The number of batches, only for contiguous iterables
+        int64_t count() const {
+            const int64_t rows = std::apply([](const auto&... sources) { return std::min({sources.size()...}); }, sources_);
+            return (rows + size_ - 1) / size_;
+        }
+
+        // The index-th batch, only for contiguous iterables
+        Current at(int64_t index) const {
+            const int64_t rows = std::apply([](const auto&... sources) { return std::min({sources.size()...}); }, sources_);
+            const int64_t count = std::min(size_, rows - index * size_);
+            return std::apply([&](const auto&... sources) { return make_batch(sources.at(index * size_, count)...); }, sources_);
+        }
+
+        // Member Variables
+        Sources sources_;
+        int64_t size_;
+        Current current_;
+
+    private:
+        template<std::size_t... Is>
+        BatchedState(std::tuple<Iterables...>& iterables, int64_t size, std::index_sequence<Is...>)
+            : sources_(BatchSource<std::remove_reference_t<Iterables>>(std::get<Is>(iterables))...)
+            , size_(size)
+            , current_()
+        {
+            if (size < 1) { throw std::invalid_argument("batched needs a batch size of at least one"); }
+            operator++();
+        }
+
+        // Cuts the spans to the shortest
+        template<class... Spans>
+        Current make_batch(const Spans&... spans) const {
+            const std::size_t rows = std::min({spans.size()...});
+            const bool partial = static_cast<int64_t>(rows) < size_;
+            return Current{{spans.first(rows)...}, partial};
+        }
+    };
+}
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // Batched - The generator batched returns
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class... Iterables>
+    class Batched {
+    public:
+        //------------------------------------------------------------------------------
+        // Initialization variables - Can only be set via aggregate initialization
+        //------------------------------------------------------------------------------
+        std::tuple<Iterables...> iterables_;
+        int64_t size_;
+        UTILITIES_LOOP_PROBE
+
+    public:
+        //------------------------------------------------------------------------------
+        // State of the generator - It's public to allow for aggregate initialization of
+        // the above variables, but this should be treated as private.
+        //------------------------------------------------------------------------------
+        using State = utilities::intern::BatchedState<Iterables...>;
+        State state_{iterables_, size_};
+
+    public:
+        //------------------------------------------------------------------------------
+        // Implicit Constructors - All Deleted
+        //------------------------------------------------------------------------------
+        constexpr Batched() = delete;
+        constexpr Batched(const Batched&) = delete;
+        constexpr Batched(Batched&&) = delete;
+        constexpr Batched& operator=(const Batched&) = delete;
+        constexpr Batched& operator=(Batched&&) = delete;
+
+    public:
+        //------------------------------------------------------------------------------
+        // Begin and End - Enables usage in ranged-for
+        //------------------------------------------------------------------------------
+        using Iterator = utilities::intern::GeneratorIterator<Batched>;
+        constexpr Iterator begin() { return Iterator{*this}; }
+        constexpr utilities::intern::GeneratorEnd end() { return {}; }
+
+    public:
+        //------------------------------------------------------------------------------
+        // Random access - Only for contiguous iterables, whose batches can be handed
+        // out by index, e.g. to threads. Independent of the iteration above.
+        //------------------------------------------------------------------------------
+        template<class S = State, class = std::enable_if_t<S::kRandomAccess>>
+        int64_t size() const { return state_.count(); }
+
+        template<class S = State, class = std::enable_if_t<S::kRandomAccess>>
+        typename State::Current operator[](int64_t index) const { return state_.at(index); }
+
+    public:
+        //------------------------------------------------------------------------------
+        // operators - Emulating the generator class's operators
+        //------------------------------------------------------------------------------
+        constexpr const typename State::Current& operator*() const { return state_.current_; }
+        constexpr Batched& operator++() { ++state_; return *this; }
+        constexpr explicit operator bool() const { return state_.can_advance(); }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // batched - Like Python 3.12's itertools.batched, yields the elements of an
+    // iterable in batches of size elements, the last batch holding the rest.
+    //      for (auto&& batch : batched(samples, 4096)) { }      // batch.size(), batch[i], batch.partial()
+    //      for (auto&& [xs, ys] : batched(zip{ x, y }, 4096)) { }
+    // Batches are spans: of the elements themselves for contiguous iterables, of a
+    // buffer reused for every batch otherwise, so they're only valid until the next
+    // one. A zip yields a span per iterable. For contiguous iterables size() and
+    // operator[] give random access to the batches, which parallel_for_each uses.
+    // Temporaries are moved into the result, lvalues are referred to. Temporary
+    // generators like range(n) or str::split hand over their state. Those whose
+    // state can't be moved, e.g. enumerate{ ... } or scandir, must be lvalues.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable>
+    auto batched(Iterable&& iterable, int64_t size UTILITIES_LOOP_SITE_PARAMS) {
+        static_assert(utilities::intern::Kept<Iterable&&>::kValid,
+                      "batched moves temporaries in, pass generators whose state can't be moved as lvalues");
+        using Kept = typename utilities::intern::Kept<Iterable&&>::type;
+        return Batched<Kept>{std::tuple<Kept>(std::forward<Iterable>(iterable)), size UTILITIES_LOOP_SITE_ARGS};
+    }
+
+    template<class... Iterables>
+    auto batched(zip<Iterables...>& zipped, int64_t size UTILITIES_LOOP_SITE_PARAMS) {
+        return std::apply([&](auto&... iterables) {
+            return Batched<std::remove_reference_t<Iterables>&...>{{iterables...}, size UTILITIES_LOOP_SITE_ARGS};
+        }, utilities::intern::zip_iterables(zipped));
+    }
+
+    template<class... Iterables>
+    auto batched(zip<Iterables...>&& zipped, int64_t size UTILITIES_LOOP_SITE_PARAMS) {
+        return std::apply([&](auto&... iterables) {
+            static_assert((utilities::intern::Kept<Iterables>::kValid && ...),
+                          "batched moves temporaries in, pass generators whose state can't be moved as lvalues");
+            return Batched<typename utilities::intern::Kept<Iterables>::type...>{
+                std::tuple<typename utilities::intern::Kept<Iterables>::type...>(static_cast<Iterables&&>(iterables)...), size UTILITIES_LOOP_SITE_ARGS};
+        }, utilities::intern::zip_iterables(zipped));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // parallel_for_each - Calls consumer(items[i]) for every index of something with
+    // size() and operator[], like the batches of contiguous iterables, on up to
+    // threads threads. The first exception thrown is rethrown once all are done.
+    //      parallel_for_each(batched(samples, 4096), [](auto batch) { ... });
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Items, class Consumer>
+    void parallel_for_each(Items&& items, Consumer&& consumer, int64_t threads = utilities::intern::hardware_threads()) {
+        utilities::intern::parallel_tasks(static_cast<int64_t>(items.size()), [&](int64_t index) {
+            consumer(items[index]);
+        }, threads);
+    }
+}
+
+// Need to do this since array and tuple define tuple_element and tuple_size as a class and a struct
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wmismatched-tags"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// tuple_element and tuple_size specializations for ZipBatch's structured bindings
+////////////////////////////////////////////////////////////////////////////////
+namespace std {
+    template<std::size_t N, class... Ts>
+    struct tuple_element<N, utilities::intern::ZipBatch<Ts...>> {
+        using type = const utilities::intern::Span<std::tuple_element_t<N, std::tuple<Ts...>>>;
+    };
+
+    template<class... Ts>
+    struct tuple_size<utilities::intern::ZipBatch<Ts...>> : std::integral_constant<std::size_t, sizeof...(Ts)> {
+        // Empty
+    };
+}
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <iterator>
 #include <utility>
 #include "generator_iterator.h"
 
@@ -32,6 +33,7 @@ namespace {
         //------------------------------------------------------------------------------
         using State = EnumerateState<decltype(std::begin(iterable_))>;
         State state_{starting_idx_, std::begin(iterable_)};
+        UTILITIES_LOOP_PROBE
 
     public:
         //------------------------------------------------------------------------------
@@ -1,5 +1,13 @@
 #pragma once
 
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "instrumentation.h"
+
 namespace utilities::intern {
     ////////////////////////////////////////////////////////////////////////////////
     // GeneratorEnd - This serves as a sentinel for when a generator is finished
@@ -28,11 +36,12 @@ namespace utilities::intern {
         //------------------------------------------------------------------------------
         // operators
         // operator* - Calls the generator operator*
-        // operator++ - Calls the generator operator++, but returns itself
+        // operator++ - Calls the generator operator++, but returns itself. Also ticks the
+        //              generator's loop probe when loop instrumentation is enabled
         // operator!= - Only defined for the Generator sentinel, calls the generators operator bool
         //------------------------------------------------------------------------------
-        constexpr decltype(auto) operator*() { return *generator_; }
-        constexpr GeneratorIterator& operator++() { ++generator_; return *this; }
+        constexpr decltype(auto) operator*() const { return *generator_; }
+        constexpr GeneratorIterator& operator++() { UTILITIES_LOOP_TICK(generator_); ++generator_; return *this; }
         constexpr bool operator!=(const GeneratorEnd&) const { return generator_.operator bool(); }
         constexpr bool operator==(const GeneratorEnd& end) const { return !operator !=(end); }
 
@@ -42,4 +51,67 @@ namespace utilities::intern {
         //------------------------------------------------------------------------------
         Generator& generator_;
     };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Owned - How functions returning generators keep an iterable: lvalues by
+    // reference, while temporaries are moved in since they don't outlive the loop's
+    // initializer
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable>
+    using Owned = std::conditional_t<std::is_rvalue_reference_v<Iterable>, std::remove_reference_t<Iterable>, Iterable>;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // HasSize - True when std::size can be called on an lvalue of the type
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class T, class = void>
+    struct HasSize : std::false_type {};
+
+    template<class T>
+    struct HasSize<T, std::void_t<decltype(std::size(std::declval<T&>()))>> : std::true_type {};
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // materialize - Copies what a generator yields into a value that stays valid once
+    // the generator advances. The states of enumerate and zip, which only refer to
+    // the current elements, become std::tuples of the elements' values. Anything
+    // else is decayed and copied.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class T, class = void>
+    struct HasMemberGet : std::false_type {};
+
+    template<class T>
+    struct HasMemberGet<T, std::void_t<decltype(std::declval<const T&>().template get<0>())>> : std::true_type {};
+
+    template<class Value>
+    constexpr auto materialize(Value&& value);
+
+    template<class State, std::size_t... Is>
+    constexpr auto materialize_state(const State& state, std::index_sequence<Is...>) {
+        return std::tuple<decltype(materialize(state.template get<Is>()))...>{materialize(state.template get<Is>())...};
+    }
+
+    template<class Value>
+    constexpr auto materialize(Value&& value) {
+        using Decayed = std::decay_t<Value>;
+        if constexpr (HasMemberGet<Decayed>::value) {
+            return materialize_state(value, std::make_index_sequence<std::tuple_size<Decayed>::value>{});
+        } else {
+            return Decayed(std::forward<Value>(value));
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // to_vector - The materialized elements of an iterable as a std::vector, for
+    // algorithms that rearrange them. An rvalue vector is moved in and reused.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable>
+    auto to_vector(Iterable&& iterable) {
+        using Value = decltype(materialize(*std::begin(iterable)));
+        if constexpr (std::is_same_v<std::decay_t<Iterable>, std::vector<Value>> && !std::is_lvalue_reference_v<Iterable>) {
+            return std::vector<Value>(std::move(iterable));
+        } else {
+            std::vector<Value> values;
+            for (auto&& value : iterable) { values.push_back(materialize(value)); }
+            return values;
+        }
+    }
 }
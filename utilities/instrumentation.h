@@ -0,0 +1,298 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Loop instrumentation - Opt-in hooks that record how often each range/enumerate/zip
+// loop in a program runs, how many iterations it makes and how long it takes.
+//
+// Define UTILITIES_LOOP_INSTRUMENTATION before including any utilities header to
+// enable it. Without the define every hook below expands to nothing and the
+// generators compile exactly as they would without this header.
+//
+// Loops are identified by the file and line where the generator is created. Each
+// thread records into its own table, so the hot path never takes a lock. The tables
+// are printed to stderr at exit, or on demand with dump_loop_stats().
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(UTILITIES_LOOP_INSTRUMENTATION)
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // LoopSiteStats - Counters for one loop site on one thread. Only the owning
+    // thread writes, so relaxed load/store pairs are enough to stay race free while
+    // another thread reads them for a dump.
+    ////////////////////////////////////////////////////////////////////////////////
+    struct LoopSiteStats {
+        // Trip counts are bucketed by bit width: bucket b holds counts in [2^(b-1), 2^b)
+        static constexpr std::size_t kTripBuckets = 34;
+
+        std::atomic<const char*> file_{nullptr};
+        std::atomic<uint32_t> line_{0};
+        std::atomic<uint64_t> loops_{0};
+        std::atomic<uint64_t> iterations_{0};
+        std::atomic<uint64_t> nanoseconds_{0};
+        std::atomic<uint64_t> trip_buckets_[kTripBuckets]{};
+
+        static void bump(std::atomic<uint64_t>& counter, uint64_t amount) {
+            counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // LoopSiteTable - Fixed size open addressing table of loop sites for one thread.
+    // A slot is claimed by publishing its file pointer last, so readers never see a
+    // half initialized key.
+    ////////////////////////////////////////////////////////////////////////////////
+    class LoopSiteTable {
+    public:
+        static constexpr std::size_t kCapacity = 1024;
+
+        LoopSiteStats* find_or_insert(const char* file, uint32_t line) {
+            std::size_t hash = (reinterpret_cast<std::uintptr_t>(file) >> 3) * 0x9E3779B97F4A7C15ull + line;
+            for (std::size_t probe = 0; probe < kCapacity; ++probe) {
+                LoopSiteStats& slot = slots_[(hash + probe) & (kCapacity - 1)];
+                const char* slot_file = slot.file_.load(std::memory_order_relaxed);
+                if (slot_file == nullptr) {
+                    slot.line_.store(line, std::memory_order_relaxed);
+                    slot.file_.store(file, std::memory_order_release);
+                    return &slot;
+                }
+                if (slot_file == file && slot.line_.load(std::memory_order_relaxed) == line) {
+                    return &slot;
+                }
+            }
+            LoopSiteStats::bump(dropped_, 1);
+            return nullptr;
+        }
+
+        const LoopSiteStats* begin() const { return slots_; }
+        const LoopSiteStats* end() const { return slots_ + kCapacity; }
+        uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    private:
+        LoopSiteStats slots_[kCapacity];
+        std::atomic<uint64_t> dropped_{0};
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // LoopRegistry - Owns every thread's table so the data outlives the threads.
+    // The mutex is only taken once per thread and when dumping.
+    ////////////////////////////////////////////////////////////////////////////////
+    class LoopRegistry {
+    public:
+        static LoopRegistry& instance() {
+            static LoopRegistry* registry = new LoopRegistry();  // Leaked on purpose, must outlive thread_locals
+            return *registry;
+        }
+
+        static LoopSiteTable& thread_table() {
+            thread_local LoopSiteTable* table = instance().add_table();
+            return *table;
+        }
+
+        void dump(std::ostream& os) {
+            struct Merged {
+                const char* file; uint32_t line;
+                uint64_t loops, iterations, nanoseconds;
+                uint64_t trip_buckets[LoopSiteStats::kTripBuckets];
+            };
+            std::vector<Merged> merged;
+            uint64_t dropped = 0;
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& table : tables_) {
+                dropped += table->dropped();
+                for (const LoopSiteStats& slot : *table) {
+                    const char* file = slot.file_.load(std::memory_order_acquire);
+                    if (file == nullptr) { continue; }
+                    uint32_t line = slot.line_.load(std::memory_order_relaxed);
+
+                    Merged* target = nullptr;
+                    for (Merged& existing : merged) {
+                        if (existing.file == file && existing.line == line) { target = &existing; break; }
+                    }
+                    if (target == nullptr) { target = &merged.emplace_back(Merged{file, line, 0, 0, 0, {}}); }
+
+                    target->loops += slot.loops_.load(std::memory_order_relaxed);
+                    target->iterations += slot.iterations_.load(std::memory_order_relaxed);
+                    target->nanoseconds += slot.nanoseconds_.load(std::memory_order_relaxed);
+                    for (std::size_t b = 0; b < LoopSiteStats::kTripBuckets; ++b) {
+                        target->trip_buckets[b] += slot.trip_buckets_[b].load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            os << "loop statistics (" << merged.size() << " sites, " << tables_.size() << " threads";
+            if (dropped != 0) { os << ", " << dropped << " loops dropped - site table full"; }
+            os << ")\n";
+            for (const Merged& site : merged) {
+                os << "  " << site.file << ":" << site.line
+                   << "  loops=" << site.loops
+                   << "  iterations=" << site.iterations
+                   << "  total_ms=" << std::fixed << std::setprecision(3) << site.nanoseconds / 1e6
+                   << "\n    trips:";
+                for (std::size_t b = 0; b < LoopSiteStats::kTripBuckets; ++b) {
+                    if (site.trip_buckets[b] == 0) { continue; }
+                    os << " [" << (b == 0 ? 0 : (uint64_t{1} << (b - 1))) << ",";
+                    if (b + 1 == LoopSiteStats::kTripBuckets) { os << "inf)"; }
+                    else { os << (uint64_t{1} << b) << ")"; }
+                    os << "=" << site.trip_buckets[b];
+                }
+                os << "\n";
+            }
+            os.flush();
+        }
+
+        // Set from a signal handler, the dump then happens at the next loop exit
+        std::atomic<bool> dump_requested_{false};
+
+    private:
+        LoopRegistry() {
+            std::atexit([] { LoopRegistry::instance().dump(std::cerr); });
+        }
+
+        LoopSiteTable* add_table() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return tables_.emplace_back(std::make_unique<LoopSiteTable>()).get();
+        }
+
+        std::mutex mutex_;
+        std::vector<std::unique_ptr<LoopSiteTable>> tables_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // LoopSite - The file and line a generator was created on. Used as a defaulted
+    // parameter, the builtins pick up the location of the outermost caller. Explicit so
+    // that integer arguments (range(3, 0)) never convert to it.
+    ////////////////////////////////////////////////////////////////////////////////
+    struct LoopSite {
+        explicit LoopSite(const char* file = __builtin_FILE(), uint32_t line = __builtin_LINE())
+            : file_(file)
+            , line_(line)
+        {
+            // Nothing
+        }
+
+        const char* file_;
+        uint32_t line_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // LoopProbe - Lives inside a generator for the duration of a loop. It counts
+    // iterations in a plain member and publishes everything once, on destruction.
+    ////////////////////////////////////////////////////////////////////////////////
+    class LoopProbe {
+    public:
+        LoopProbe(LoopSite site = LoopSite{})
+            : file_(site.file_)
+            , line_(site.line_)
+            , start_(std::chrono::steady_clock::now())
+        {
+            // Nothing
+        }
+
+        LoopProbe(const LoopProbe&) = delete;
+        LoopProbe& operator=(const LoopProbe&) = delete;
+
+        ~LoopProbe() {
+            if (file_ == nullptr) { return; }
+            auto elapsed = std::chrono::steady_clock::now() - start_;
+            if (LoopSiteStats* stats = LoopRegistry::thread_table().find_or_insert(file_, line_)) {
+                std::size_t bucket = 0;
+                for (uint64_t trips = iterations_; trips != 0 && bucket + 1 < LoopSiteStats::kTripBuckets; trips >>= 1) {
+                    ++bucket;
+                }
+                LoopSiteStats::bump(stats->loops_, 1);
+                LoopSiteStats::bump(stats->iterations_, iterations_);
+                LoopSiteStats::bump(stats->nanoseconds_,
+                    static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+                LoopSiteStats::bump(stats->trip_buckets_[bucket], 1);
+            }
+
+            LoopRegistry& registry = LoopRegistry::instance();
+            if (registry.dump_requested_.load(std::memory_order_relaxed) &&
+                registry.dump_requested_.exchange(false)) {
+                registry.dump(std::cerr);
+            }
+        }
+
+        void operator++() { ++iterations_; }
+
+        // For a generator whose state was taken over by another one: it records no
+        // loop of its own, and its site is handed to the probe of the other one
+        LoopSite forget() {
+            LoopSite site{file_, line_};
+            file_ = nullptr;
+            return site;
+        }
+
+    private:
+        const char* file_;
+        uint32_t line_;
+        uint64_t iterations_ = 0;
+        std::chrono::steady_clock::time_point start_;
+    };
+}
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // dump_loop_stats - Prints the statistics gathered so far, merged across threads
+    ////////////////////////////////////////////////////////////////////////////////
+    inline void dump_loop_stats(std::ostream& os = std::cerr) {
+        utilities::intern::LoopRegistry::instance().dump(os);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // dump_loop_stats_on_signal - Requests a dump whenever signum is received. Printing
+    // from inside a signal handler isn't safe, so the dump is deferred until the next
+    // instrumented loop finishes.
+    ////////////////////////////////////////////////////////////////////////////////
+    inline void dump_loop_stats_on_signal(int signum) {
+        utilities::intern::LoopRegistry::instance();  // Construct outside of the handler
+        std::signal(signum, [](int) {
+            utilities::intern::LoopRegistry::instance().dump_requested_.store(true, std::memory_order_relaxed);
+        });
+    }
+}
+
+//------------------------------------------------------------------------------
+// Hooks used by the generators
+// UTILITIES_LOOP_PROBE - Member declaration added to each generator
+// UTILITIES_LOOP_TICK - Called by GeneratorIterator on every advance
+// UTILITIES_LOOP_SITE_PARAMS/ARGS - Forward the caller's location through factory functions
+// UTILITIES_LOOP_SITE_FORWARD - Forwards it to a constructor called through emplace and the like
+// UTILITIES_LOOP_PROBE_FROM - Initializes the probe of a generator with a constructor from a site
+// UTILITIES_LOOP_FORGET - Stops a generator's probe from recording, returns its site
+// UTILITIES_LOOP_CONSTEXPR - Generators with a probe are no longer literal types
+//------------------------------------------------------------------------------
+#define UTILITIES_LOOP_PROBE utilities::intern::LoopProbe loop_probe_{};
+#define UTILITIES_LOOP_TICK(generator) ++(generator).loop_probe_
+#define UTILITIES_LOOP_SITE_PARAMS , utilities::intern::LoopSite loop_site = utilities::intern::LoopSite{}
+#define UTILITIES_LOOP_SITE_ARGS , {loop_site}
+#define UTILITIES_LOOP_SITE_FORWARD , loop_site
+#define UTILITIES_LOOP_PROBE_FROM(site) , loop_probe_(site)
+#define UTILITIES_LOOP_FORGET(generator) (generator).loop_probe_.forget()
+#define UTILITIES_LOOP_CONSTEXPR inline
+
+#else
+
+#define UTILITIES_LOOP_PROBE
+#define UTILITIES_LOOP_TICK(generator) ((void)0)
+#define UTILITIES_LOOP_SITE_PARAMS
+#define UTILITIES_LOOP_SITE_ARGS
+#define UTILITIES_LOOP_SITE_FORWARD
+#define UTILITIES_LOOP_PROBE_FROM(site)
+#define UTILITIES_LOOP_FORGET(generator) ((void)0)
+#define UTILITIES_LOOP_CONSTEXPR constexpr
+
+#endif
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "arena.h"
+#include "list.h"
+#include "size_hint.h"
+#include "unique.h"
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // InternHeader - Stored in front of the characters of every interned string,
+    // which are followed by a terminating zero
+    ////////////////////////////////////////////////////////////////////////////////
+    struct InternHeader {
+        uint64_t hash;
+        uint32_t id;
+        uint32_t size;
+
+        const char* data() const { return reinterpret_cast<const char*>(this + 1); }
+    };
+
+    // The empty string isn't stored in the tables, all of its handles refer to this
+    struct EmptyInterned {
+        InternHeader header{0, 0, 0};
+        char terminator = '\0';
+    };
+    inline const EmptyInterned kEmptyInterned{};
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // InternTable - An open addressing table of the strings of one shard. Slots are
+    // only ever filled, so they're read without locking.
+    ////////////////////////////////////////////////////////////////////////////////
+    struct InternTable {
+        explicit InternTable(std::size_t capacity)
+            : mask(capacity - 1)
+            , slots(new std::atomic<const InternHeader*>[capacity])
+        {
+            for (std::size_t slot = 0; slot < capacity; ++slot) { slots[slot].store(nullptr, std::memory_order_relaxed); }
+        }
+
+        // The string or the empty slot it would go into
+        std::atomic<const InternHeader*>& find(std::string_view text, uint64_t hash) const {
+            for (std::size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+                const InternHeader* header = slots[slot].load(std::memory_order_acquire);
+                if (header == nullptr || (header->hash == hash && header->size == text.size() &&
+                                          std::memcmp(header->data(), text.data(), text.size()) == 0)) {
+                    return slots[slot];
+                }
+            }
+        }
+
+        const std::size_t mask;
+        const std::unique_ptr<std::atomic<const InternHeader*>[]> slots;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Interner - The strings interned by all threads, split into shards by hash.
+    // Looking up a string that is already interned takes no lock. Adding one locks
+    // its shard, which copies it into its arena and, at half load, publishes a table
+    // twice the size. Replaced tables are kept since readers may still probe them.
+    ////////////////////////////////////////////////////////////////////////////////
+    class Interner {
+    public:
+        static constexpr std::size_t kShards = 64;
+
+        const InternHeader* get(std::string_view text, uint64_t hash) {
+            Shard& shard = shards_[hash >> 58];
+            const InternHeader* header = shard.table.load(std::memory_order_acquire)->find(text, hash).load(std::memory_order_acquire);
+            return header != nullptr ? header : insert(shard, text, hash);
+        }
+
+        // Where a lookup of hash starts, to be prefetched by bulk interning
+        const void* slot_of(uint64_t hash) const {
+            const InternTable* table = shards_[hash >> 58].table.load(std::memory_order_acquire);
+            return &table->slots[hash & table->mask];
+        }
+
+    private:
+        struct alignas(64) Shard {
+            Shard() {
+                tables.push_back(std::make_unique<InternTable>(64));
+                table.store(tables.back().get(), std::memory_order_relaxed);
+            }
+
+            std::atomic<InternTable*> table;
+            std::mutex mutex;
+            Arena strings{std::size_t(64) << 10};
+            std::vector<std::unique_ptr<InternTable>> tables;
+            std::size_t size = 0;
+        };
+
+        const InternHeader* insert(Shard& shard, std::string_view text, uint64_t hash) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            InternTable* table = shard.table.load(std::memory_order_relaxed);
+            if (const InternHeader* header = table->find(text, hash).load(std::memory_order_relaxed)) { return header; }
+
+            if (2 * (shard.size + 1) > table->mask + 1) {
+                auto grown = std::make_unique<InternTable>(2 * (table->mask + 1));
+                for (std::size_t slot = 0; slot <= table->mask; ++slot) {
+                    if (const InternHeader* header = table->slots[slot].load(std::memory_order_relaxed)) {
+                        grown->find({header->data(), header->size}, header->hash).store(header, std::memory_order_relaxed);
+                    }
+                }
+                table = grown.get();
+                shard.tables.push_back(std::move(grown));
+                shard.table.store(table, std::memory_order_release);
+            }
+
+            void* memory = shard.strings.allocate(sizeof(InternHeader) + text.size() + 1, alignof(InternHeader));
+            const uint32_t id = next_id_.fetch_add(1, std::memory_order_relaxed);
+            auto* header = new (memory) InternHeader{hash, id, static_cast<uint32_t>(text.size())};
+            char* data = reinterpret_cast<char*>(header + 1);
+            std::memcpy(data, text.data(), text.size());
+            data[text.size()] = '\0';
+            table->find(text, hash).store(header, std::memory_order_release);
+            ++shard.size;
+            return header;
+        }
+
+        std::array<Shard, kShards> shards_;
+        std::atomic<uint32_t> next_id_{1};
+    };
+
+    inline Interner& interner() {
+        static Interner instance;
+        return instance;
+    }
+
+    inline uint64_t intern_hash(std::string_view text) {
+        // 0 is kept for the empty string. Only that one value is remapped, since a bit
+        // forced on would be the same in every home slot and every hash handed out.
+        const uint64_t hash = hash_key(text);
+        return hash != 0 ? hash : 1;
+    }
+}
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // interned - A handle to a string interned by intern, like the strings returned
+    // by Python's sys.intern. Equal strings get the same handle, so comparing two
+    // is comparing pointers and their hash was computed once, when interning. Ids
+    // number the distinct strings from 1, the empty string has id 0.
+    // Interned strings live until the program ends.
+    ////////////////////////////////////////////////////////////////////////////////
+    class interned {
+    public:
+        interned() : interned(&utilities::intern::kEmptyInterned.header) { }
+
+        explicit interned(const utilities::intern::InternHeader* header)
+            : data_(header->data())
+            , id_(header->id)
+            , size_(header->size)
+        {
+            // Nothing
+        }
+
+        std::string_view view() const { return {data_, size_}; }
+        operator std::string_view() const { return view(); }
+        const char* c_str() const { return data_; }
+        std::size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        uint32_t id() const { return id_; }
+        uint64_t hash() const { return reinterpret_cast<const utilities::intern::InternHeader*>(data_)[-1].hash; }
+
+        bool operator==(const interned& other) const { return data_ == other.data_; }
+        bool operator!=(const interned& other) const { return data_ != other.data_; }
+        // Ordered by the strings, so sorting gives the same order in every run
+        bool operator<(const interned& other) const { return view() < other.view(); }
+
+    private:
+        const char* data_;
+        uint32_t id_;
+        uint32_t size_;
+    };
+
+    inline std::ostream& operator<<(std::ostream& os, const interned& text) {
+        return os << text.view();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // intern - The handle of a string, adding it to the strings interned by all
+    // threads if it isn't one yet.
+    //      interned field = intern("timestamp");
+    //      if (field == intern(name)) { }    // compares pointers
+    // intern(iterable) interns every string of an iterable. Those of contiguous
+    // iterables are looked up a batch at a time so that the tables' cache misses
+    // overlap.
+    ////////////////////////////////////////////////////////////////////////////////
+    inline interned intern(std::string_view text) {
+        if (text.empty()) { return interned{}; }
+        return interned{utilities::intern::interner().get(text, utilities::intern::intern_hash(text))};
+    }
+
+    template<class Iterable, class = std::enable_if_t<!std::is_convertible_v<Iterable&&, std::string_view>>>
+    list<interned> intern(Iterable&& texts) {
+        constexpr std::size_t kBatch = 16;
+        utilities::intern::Interner& interner = utilities::intern::interner();
+        list<interned> handles;
+        if (const auto hint = utilities::intern::size_hint(texts)) { handles.reserve(static_cast<std::size_t>(*hint)); }
+
+        std::array<std::string_view, kBatch> batch;
+        std::array<uint64_t, kBatch> hashes;
+        std::size_t count = 0;
+        auto flush = [&]() {
+            for (std::size_t i = 0; i < count; ++i) {
+                hashes[i] = utilities::intern::intern_hash(batch[i]);
+#if defined(__GNUC__) || defined(__clang__)
+                __builtin_prefetch(interner.slot_of(hashes[i]));
+#endif
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                handles.append(batch[i].empty() ? interned{} : interned{interner.get(batch[i], hashes[i])});
+            }
+            count = 0;
+        };
+        if constexpr (std::is_void_v<typename utilities::intern::ContiguousElement<std::remove_reference_t<Iterable>>::type>) {
+            // Generators may yield temporaries, which can't wait for the rest of a batch
+            for (auto&& text : texts) { handles.append(intern(std::string_view(text))); }
+        } else {
+            for (const auto& text : texts) {
+                batch[count++] = std::string_view(text);
+                if (count == kBatch) { flush(); }
+            }
+            flush();
+        }
+        return handles;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// std::hash specialization - The hash computed when interning
+////////////////////////////////////////////////////////////////////////////////
+namespace std {
+    template<>
+    struct hash<interned> {
+        std::size_t operator()(const interned& text) const { return static_cast<std::size_t>(text.hash()); }
+    };
+}
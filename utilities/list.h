@@ -0,0 +1,284 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "size_hint.h"
+#include "span.h"
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // IsTriviallyRelocatable - Types that can be moved to a new address by copying
+    // their bytes and forgetting the old ones, so that list can grow them in place
+    // with realloc. Trivially copyable types are, specialize it for others that are.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class T>
+    struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+
+    constexpr std::size_t kListInlineBytes = 64;
+}
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // list - Like Python's list, a growable array. The first InlineCapacity elements
+    // are stored inside the list itself, so small lists never allocate. Beyond that
+    // the capacity doubles, through realloc for trivially relocatable types, which
+    // often extends the allocation without copying anything.
+    //      list<int> values{ 1, 2, 3 };
+    //      values.append(4);
+    //      values.extend(range(5, 10));    // reserves once, from the size hint
+    //      int first = values.pop(0);       // amortized O(1)
+    // pop(0) only moves the start of the list forward, the space in front is reused
+    // once it is at least half the capacity, rather than growing.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class T, std::size_t InlineCapacity = std::max<std::size_t>(1, utilities::intern::kListInlineBytes / sizeof(T))>
+    class list {
+        static_assert(InlineCapacity > 0, "list needs room for at least one element inline");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "list allocates with malloc");
+
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference = T&;
+        using const_reference = const T&;
+        using iterator = T*;
+        using const_iterator = const T*;
+
+        //------------------------------------------------------------------------------
+        // Constructors
+        //------------------------------------------------------------------------------
+        list() = default;
+
+        list(std::initializer_list<T> values) { extend(values); }
+
+        template<class Iterable, class = std::enable_if_t<!std::is_same_v<std::decay_t<Iterable>, list>>>
+        explicit list(Iterable&& iterable) { extend(std::forward<Iterable>(iterable)); }
+
+        list(const list& other) { extend(other); }
+
+        list(list&& other) noexcept(std::is_nothrow_move_constructible_v<T>) { take(other); }
+
+        list& operator=(const list& other) {
+            if (this != &other) {
+                clear();
+                extend(other);
+            }
+            return *this;
+        }
+
+        list& operator=(list&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+            if (this != &other) {
+                clear();
+                free_storage();
+                take(other);
+            }
+            return *this;
+        }
+
+        ~list() {
+            clear();
+            free_storage();
+        }
+
+        //------------------------------------------------------------------------------
+        // Python's list methods
+        //------------------------------------------------------------------------------
+        void append(const T& value) { emplace_back(value); }
+        void append(T&& value) { emplace_back(std::move(value)); }
+
+        // Appends every element, reserving up front when the iterable's size is known
+        template<class Iterable>
+        void extend(Iterable&& iterable) {
+            if constexpr (std::is_same_v<typename utilities::intern::ContiguousValue<std::remove_reference_t<Iterable>>::type, T>) {
+                const std::size_t count = std::size(iterable);
+                reserve(size_ + count);
+                // Only read after reserving, which may have moved it if it is this list
+                std::uninitialized_copy_n(std::data(iterable), count, first_ + size_);
+                size_ += count;
+            } else {
+                if (const auto hint = utilities::intern::size_hint(iterable)) { reserve(size_ + static_cast<std::size_t>(*hint)); }
+                for (auto&& value : iterable) { emplace_back(std::forward<decltype(value)>(value)); }
+            }
+        }
+
+        void insert(std::size_t index, T value) {
+            if (index >= size_) {
+                emplace_back(std::move(value));
+                return;
+            }
+            if (first_ + size_ == storage_ + capacity_) { make_room(1); }
+            new (first_ + size_) T(std::move(first_[size_ - 1]));
+            std::move_backward(first_ + index, first_ + size_ - 1, first_ + size_);
+            first_[index] = std::move(value);
+            ++size_;
+        }
+
+        // Removes and returns the last element
+        T pop() {
+            T value = std::move(first_[size_ - 1]);
+            first_[--size_].~T();
+            return value;
+        }
+
+        // Removes and returns the element at index, pop(0) in O(1)
+        T pop(std::size_t index) {
+            T value = std::move(first_[index]);
+            if (index == 0) {
+                first_->~T();
+                ++first_;
+                if (--size_ == 0) { first_ = storage_; }
+            } else {
+                std::move(first_ + index + 1, first_ + size_, first_ + index);
+                first_[--size_].~T();
+            }
+            return value;
+        }
+
+        void clear() {
+            std::destroy_n(first_, size_);
+            first_ = storage_;
+            size_ = 0;
+        }
+
+        //------------------------------------------------------------------------------
+        // std::vector's interface, so that standard algorithms and inserters work
+        //------------------------------------------------------------------------------
+        template<class... Args>
+        T& emplace_back(Args&&... args) {
+            if (first_ + size_ == storage_ + capacity_) {
+                // The arguments may refer to an element, construct before moving them
+                T value(std::forward<Args>(args)...);
+                make_room(1);
+                new (first_ + size_) T(std::move(value));
+            } else {
+                new (first_ + size_) T(std::forward<Args>(args)...);
+            }
+            return first_[size_++];
+        }
+
+        void push_back(const T& value) { emplace_back(value); }
+        void push_back(T&& value) { emplace_back(std::move(value)); }
+        void pop_back() { first_[--size_].~T(); }
+
+        // Makes room for count elements in total without reallocating
+        void reserve(std::size_t count) {
+            if (first_ + count <= storage_ + capacity_) { return; }
+            if (count <= capacity_) {
+                move_to_front();
+            } else {
+                reallocate(std::max(count, 2 * capacity_));
+            }
+        }
+
+        T& operator[](std::size_t index) { return first_[index]; }
+        const T& operator[](std::size_t index) const { return first_[index]; }
+        T& front() { return first_[0]; }
+        const T& front() const { return first_[0]; }
+        T& back() { return first_[size_ - 1]; }
+        const T& back() const { return first_[size_ - 1]; }
+
+        T* data() { return first_; }
+        const T* data() const { return first_; }
+        T* begin() { return first_; }
+        const T* begin() const { return first_; }
+        T* end() { return first_ + size_; }
+        const T* end() const { return first_ + size_; }
+
+        std::size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        std::size_t capacity() const { return capacity_; }
+
+        bool operator==(const list& other) const { return std::equal(begin(), end(), other.begin(), other.end()); }
+        bool operator!=(const list& other) const { return !(*this == other); }
+
+    private:
+        T* inline_data() { return std::launder(reinterpret_cast<T*>(inline_)); }
+        bool on_heap() const { return storage_ != reinterpret_cast<const T*>(inline_); }
+
+        void free_storage() {
+            if (on_heap()) { std::free(storage_); }
+            storage_ = first_ = inline_data();
+            capacity_ = InlineCapacity;
+        }
+
+        // Moves the elements of other over, stealing its allocation if it has one
+        void take(list& other) {
+            if (other.on_heap()) {
+                storage_ = other.storage_;
+                first_ = other.first_;
+                size_ = other.size_;
+                capacity_ = other.capacity_;
+                other.storage_ = other.first_ = other.inline_data();
+                other.capacity_ = InlineCapacity;
+                other.size_ = 0;
+            } else {
+                relocate(other.first_, other.size_, first_);
+                size_ = other.size_;
+                other.first_ = other.storage_;
+                other.size_ = 0;
+            }
+        }
+
+        // Room for extra more elements: the space pop(0) left in front once it is at
+        // least half the capacity, which amortizes the move, else a larger allocation
+        void make_room(std::size_t extra) {
+            if (first_ != storage_ && 2 * static_cast<std::size_t>(first_ - storage_) >= capacity_ && size_ + extra <= capacity_) {
+                move_to_front();
+            } else {
+                reallocate(std::max(2 * capacity_, size_ + extra));
+            }
+        }
+
+        void move_to_front() {
+            relocate(first_, size_, storage_);
+            first_ = storage_;
+        }
+
+        // Moves count elements from source to destination, which may overlap when the
+        // destination comes first, and ends their lifetime at source
+        static void relocate(T* source, std::size_t count, T* destination) {
+            if constexpr (utilities::intern::IsTriviallyRelocatable<T>::value) {
+                if (count > 0) { std::memmove(static_cast<void*>(destination), source, count * sizeof(T)); }
+            } else {
+                for (std::size_t i = 0; i < count; ++i) {
+                    new (destination + i) T(std::move(source[i]));
+                    source[i].~T();
+                }
+            }
+        }
+
+        void reallocate(std::size_t capacity) {
+            if constexpr (utilities::intern::IsTriviallyRelocatable<T>::value) {
+                if (on_heap()) {
+                    move_to_front();
+                    void* storage = std::realloc(static_cast<void*>(storage_), capacity * sizeof(T));
+                    if (storage == nullptr) { throw std::bad_alloc(); }
+                    storage_ = first_ = static_cast<T*>(storage);
+                    capacity_ = capacity;
+                    return;
+                }
+            }
+            T* storage = static_cast<T*>(std::malloc(capacity * sizeof(T)));
+            if (storage == nullptr) { throw std::bad_alloc(); }
+            relocate(first_, size_, storage);
+            if (on_heap()) { std::free(storage_); }
+            storage_ = first_ = storage;
+            capacity_ = capacity;
+        }
+
+        T* storage_ = inline_data();
+        T* first_ = storage_;
+        std::size_t size_ = 0;
+        std::size_t capacity_ = InlineCapacity;
+        alignas(T) unsigned char inline_[InlineCapacity * sizeof(T)];
+    };
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // hardware_threads - The number of threads the hardware runs concurrently, at least 1
+    ////////////////////////////////////////////////////////////////////////////////
+    inline int64_t hardware_threads() {
+        return std::max<int64_t>(1, static_cast<int64_t>(std::thread::hardware_concurrency()));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // parallel_tasks - Runs task(i) for every i in [0, count) on up to threads threads,
+    // the calling thread being one of them. Tasks are handed out in order through a
+    // shared counter, so uneven tasks balance out. Returns once all tasks are done;
+    // the first exception thrown by a task is rethrown then.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Task>
+    void parallel_tasks(int64_t count, Task&& task, int64_t threads = hardware_threads()) {
+        threads = std::min(std::max<int64_t>(threads, 1), count);
+        if (threads <= 1) {
+            for (int64_t i = 0; i < count; ++i) { task(i); }
+            return;
+        }
+
+        std::atomic<int64_t> next{0};
+        std::exception_ptr error;
+        std::mutex error_mutex;
+        auto work = [&] {
+            for (int64_t i = next++; i < count; i = next++) {
+                try {
+                    task(i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error) { error = std::current_exception(); }
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        for (int64_t i = 1; i < threads; ++i) { workers.emplace_back(work); }
+        work();
+        for (std::thread& worker : workers) { worker.join(); }
+        if (error) { std::rethrow_exception(error); }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ConcurrentQueue - A bounded queue any number of threads push to and pop from.
+    // push waits while the queue is full, pop while it is empty. Once closed, pushes
+    // are refused and pops drain what is left, so closing both ends a producer that
+    // should stop and tells consumers that nothing more is coming.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class T>
+    class ConcurrentQueue {
+    public:
+        explicit ConcurrentQueue(std::size_t capacity) : capacity_(std::max<std::size_t>(capacity, 1)) { }
+
+        // false if the queue was closed, value is dropped then
+        bool push(T value) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_full_.wait(lock, [&]() { return closed_ || values_.size() < capacity_; });
+            if (closed_) { return false; }
+            values_.push_back(std::move(value));
+            not_empty_.notify_one();
+            return true;
+        }
+
+        // false once the queue is closed and empty
+        bool pop(T& value) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock, [&]() { return closed_ || !values_.empty(); });
+            if (values_.empty()) { return false; }
+            value = std::move(values_.front());
+            values_.pop_front();
+            not_full_.notify_one();
+            return true;
+        }
+
+        void close() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            not_full_.notify_all();
+            not_empty_.notify_all();
+        }
+
+    private:
+        const std::size_t capacity_;
+        std::mutex mutex_;
+        std::condition_variable not_full_;
+        std::condition_variable not_empty_;
+        std::deque<T> values_;
+        bool closed_ = false;
+    };
+}
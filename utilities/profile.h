@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "timeit.h"
+
+#ifndef UTILITIES_PROFILE_BUFFER_EVENTS
+#define UTILITIES_PROFILE_BUFFER_EVENTS (1 << 16)
+#endif
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // ProfileEvent - One scope entry or exit. Names must outlive the profile, string
+    // literals are expected.
+    ////////////////////////////////////////////////////////////////////////////////
+    struct ProfileEvent {
+        const char* name;
+        uint64_t ticks : 63;
+        uint64_t is_begin : 1;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ProfileBuffer - Ring buffer of one thread's events. Only the owner writes. Once
+    // full the oldest events are overwritten, which the aggregation tolerates.
+    ////////////////////////////////////////////////////////////////////////////////
+    class ProfileBuffer {
+    public:
+        static constexpr uint64_t kCapacity = UTILITIES_PROFILE_BUFFER_EVENTS;
+        static_assert((kCapacity & (kCapacity - 1)) == 0, "The profile buffer size must be a power of two");
+
+        explicit ProfileBuffer(int64_t thread_id) : thread_id_(thread_id) { }
+
+        void push(const char* name, bool is_begin) {
+            const uint64_t written = written_.load(std::memory_order_relaxed);
+            events_[written & (kCapacity - 1)] = ProfileEvent{name, TickTimer::instance().now(), is_begin};
+            written_.store(written + 1, std::memory_order_release);
+        }
+
+        // The events still held, oldest first
+        std::vector<ProfileEvent> snapshot() const {
+            const uint64_t written = written_.load(std::memory_order_acquire);
+            const uint64_t first = written > kCapacity ? written - kCapacity : 0;
+            std::vector<ProfileEvent> events;
+            events.reserve(written - first);
+            for (uint64_t i = first; i < written; ++i) { events.push_back(events_[i & (kCapacity - 1)]); }
+            return events;
+        }
+
+        int64_t thread_id() const { return thread_id_; }
+
+    private:
+        const int64_t thread_id_;
+        std::atomic<uint64_t> written_{0};
+        std::unique_ptr<ProfileEvent[]> events_{new ProfileEvent[kCapacity]};
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ProfileNode - A node of the aggregated call tree. Times are in timer ticks.
+    ////////////////////////////////////////////////////////////////////////////////
+    struct ProfileNode {
+        int64_t calls = 0;
+        uint64_t inclusive = 0;
+        uint64_t children_time = 0;
+        std::map<std::string, ProfileNode> children;
+
+        uint64_t exclusive() const { return inclusive > children_time ? inclusive - children_time : 0; }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ProfileRegistry - Owns every thread's buffer so they outlive the threads. The
+    // mutex is only taken once per thread and when reporting.
+    ////////////////////////////////////////////////////////////////////////////////
+    class ProfileRegistry {
+    public:
+        static ProfileRegistry& instance() {
+            static ProfileRegistry* registry = new ProfileRegistry();  // Leaked on purpose, must outlive thread_locals
+            return *registry;
+        }
+
+        static ProfileBuffer& thread_buffer() {
+            thread_local ProfileBuffer* buffer = instance().add_buffer();
+            return *buffer;
+        }
+
+        // Builds the call tree of all threads, merging scopes with the same path
+        ProfileNode call_tree() {
+            ProfileNode root;
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& buffer : buffers_) {
+                struct Open { ProfileNode* node; uint64_t begin; };
+                std::vector<Open> stack;
+                for (const ProfileEvent& event : buffer->snapshot()) {
+                    if (event.is_begin) {
+                        ProfileNode& parent = stack.empty() ? root : *stack.back().node;
+                        stack.push_back({&parent.children[event.name], event.ticks});
+                        continue;
+                    }
+                    // An exit whose entry was overwritten in the ring buffer
+                    if (stack.empty()) { continue; }
+
+                    const uint64_t elapsed = event.ticks - stack.back().begin;
+                    ProfileNode& node = *stack.back().node;
+                    ++node.calls;
+                    node.inclusive += elapsed;
+                    stack.pop_back();
+                    (stack.empty() ? root : *stack.back().node).children_time += elapsed;
+                }
+            }
+            return root;
+        }
+
+        void write_chrome_trace(std::ostream& os) {
+            const TickTimer& timer = TickTimer::instance();
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            uint64_t origin = UINT64_MAX;
+            std::vector<std::pair<int64_t, std::vector<ProfileEvent>>> threads;
+            for (const auto& buffer : buffers_) {
+                threads.emplace_back(buffer->thread_id(), buffer->snapshot());
+                if (!threads.back().second.empty()) { origin = std::min<uint64_t>(origin, threads.back().second.front().ticks); }
+            }
+
+            os << "{\"traceEvents\":[";
+            bool first = true;
+            for (const auto& [thread_id, events] : threads) {
+                for (const ProfileEvent& event : events) {
+                    os << (first ? "\n" : ",\n") << "{\"name\":\"";
+                    for (const char* c = event.name; *c != '\0'; ++c) {
+                        if (*c == '"' || *c == '\\') { os << '\\'; }
+                        os << *c;
+                    }
+                    os << "\",\"ph\":\"" << (event.is_begin ? 'B' : 'E') << "\",\"ts\":"
+                       << std::fixed << std::setprecision(3) << timer.seconds(event.ticks - origin) * 1e6
+                       << ",\"pid\":1,\"tid\":" << thread_id << "}";
+                    first = false;
+                }
+            }
+            os << "\n]}\n";
+        }
+
+    private:
+        ProfileRegistry() = default;
+
+        ProfileBuffer* add_buffer() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto thread_id = static_cast<int64_t>(buffers_.size());
+            return buffers_.emplace_back(std::make_unique<ProfileBuffer>(thread_id)).get();
+        }
+
+        std::mutex mutex_;
+        std::vector<std::unique_ptr<ProfileBuffer>> buffers_;
+    };
+}
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // profile_scope - Records the time between its construction and destruction under
+    // name, nested in whatever scopes are open on the same thread.
+    //      {
+    //          profile_scope scope("parse");
+    //          ...
+    //      }
+    ////////////////////////////////////////////////////////////////////////////////
+    class profile_scope {
+    public:
+        explicit profile_scope(const char* name)
+            : buffer_(utilities::intern::ProfileRegistry::thread_buffer())
+            , name_(name)
+        {
+            buffer_.push(name_, true);
+        }
+
+        ~profile_scope() { buffer_.push(name_, false); }
+
+        profile_scope(const profile_scope&) = delete;
+        profile_scope(profile_scope&&) = delete;
+        profile_scope& operator=(const profile_scope&) = delete;
+        profile_scope& operator=(profile_scope&&) = delete;
+
+    private:
+        utilities::intern::ProfileBuffer& buffer_;
+        const char* const name_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // profiled - Wraps a task so that every call of it is a profile scope. Meant for
+    // work handed to threads:
+    //      std::thread worker(profiled("worker", [&] { ... }));
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Function>
+    auto profiled(const char* name, Function&& fn) {
+        return [name, fn = std::forward<Function>(fn)](auto&&... args) mutable -> decltype(auto) {
+            profile_scope scope(name);
+            return fn(std::forward<decltype(args)>(args)...);
+        };
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Reporting - Call these once the profiled threads are done, the buffers are
+    // read without synchronizing with threads that are still writing.
+    // dump_profile - Prints the call tree with call counts, inclusive and exclusive ms
+    // write_chrome_trace - Writes the events in the Chrome trace event format, which
+    //                      chrome://tracing and Perfetto can open
+    // profile_report_at_exit - Does both at exit, the trace only if a path is given
+    ////////////////////////////////////////////////////////////////////////////////
+    inline void dump_profile(std::ostream& os = std::cerr) {
+        const utilities::intern::TickTimer& timer = utilities::intern::TickTimer::instance();
+        auto print = [&](auto& self, const utilities::intern::ProfileNode& node, int depth) -> void {
+            for (const auto& [name, child] : node.children) {
+                os << std::string(2 + depth * 2, ' ') << name
+                   << "  calls=" << child.calls
+                   << std::fixed << std::setprecision(3)
+                   << "  inclusive_ms=" << timer.seconds(child.inclusive) * 1e3
+                   << "  exclusive_ms=" << timer.seconds(child.exclusive()) * 1e3 << "\n";
+                self(self, child, depth + 1);
+            }
+        };
+        os << "profile\n";
+        print(print, utilities::intern::ProfileRegistry::instance().call_tree(), 0);
+        os.flush();
+    }
+
+    inline void write_chrome_trace(std::ostream& os) {
+        utilities::intern::ProfileRegistry::instance().write_chrome_trace(os);
+    }
+
+    inline void write_chrome_trace(const std::string& path) {
+        std::ofstream file(path);
+        write_chrome_trace(file);
+    }
+
+    inline void profile_report_at_exit(std::string trace_path = {}) {
+        static std::string registered_path;
+        registered_path = std::move(trace_path);
+        utilities::intern::ProfileRegistry::instance();  // Constructed before the handler is registered
+        std::atexit([] {
+            dump_profile(std::cerr);
+            if (!registered_path.empty()) { write_chrome_trace(registered_path); }
+        });
+    }
+}
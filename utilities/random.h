@@ -0,0 +1,565 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "generator_iterator.h"
+#include "parallel.h"
+#include "simd.h"
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // splitmix64 - Used to expand a single seed into a full generator state
+    ////////////////////////////////////////////////////////////////////////////////
+    constexpr uint64_t splitmix64(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    constexpr uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    // The 128 bit product of a and b, returns the high half and stores the low one
+    constexpr uint64_t multiply_wide(uint64_t a, uint64_t b, uint64_t& low) {
+#if defined(__SIZEOF_INT128__)
+        __extension__ typedef unsigned __int128 Wide;
+        const Wide product = static_cast<Wide>(a) * b;
+        low = static_cast<uint64_t>(product);
+        return static_cast<uint64_t>(product >> 64);
+#else
+        const uint64_t a_low = a & 0xFFFFFFFFu, a_high = a >> 32;
+        const uint64_t b_low = b & 0xFFFFFFFFu, b_high = b >> 32;
+        const uint64_t low_low = a_low * b_low, low_high = a_low * b_high, high_low = a_high * b_low;
+        const uint64_t middle = (low_low >> 32) + (low_high & 0xFFFFFFFFu) + (high_low & 0xFFFFFFFFu);
+        low = (low_low & 0xFFFFFFFFu) | (middle << 32);
+        return a_high * b_high + (low_high >> 32) + (high_low >> 32) + (middle >> 32);
+#endif
+    }
+
+    // The top 53 bits as a double in [0, 1)
+    constexpr double to_unit_double(uint64_t bits) {
+        return static_cast<double>(static_cast<int64_t>(bits >> 11)) * 0x1.0p-53;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // skip - Advances it by up to count elements without going past end and returns
+    // whether it still points at an element. Constant time for random access
+    // iterators, element by element for everything else, e.g. generators.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterator, class End, class = void>
+    struct IsRandomAccess : std::false_type {};
+
+    template<class Iterator, class End>
+    struct IsRandomAccess<Iterator, End, std::void_t<typename std::iterator_traits<Iterator>::iterator_category>>
+        : std::bool_constant<std::is_same_v<Iterator, End> && std::is_base_of_v<std::random_access_iterator_tag,
+                             typename std::iterator_traits<Iterator>::iterator_category>> {};
+
+    template<class Iterator, class End>
+    bool skip(Iterator& it, const End& end, int64_t count) {
+        if constexpr (IsRandomAccess<Iterator, End>::value) {
+            if (end - it <= count) { it = end; return false; }
+            it += count;
+            return true;
+        } else {
+            for (; count > 0 && it != end; --count) { ++it; }
+            return it != end;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // XoshiroLanes - kLanes independent xoshiro256++ generators stepped side by side.
+    // With wide vectors each state word is one SIMD register, so every step
+    // produces kLanes outputs with a handful of vector instructions.
+    ////////////////////////////////////////////////////////////////////////////////
+    class XoshiroLanes {
+    public:
+        static constexpr std::size_t kLanes = 4;
+
+        explicit XoshiroLanes(uint64_t seed) {
+            for (std::size_t lane = 0; lane < kLanes; ++lane) {
+                for (auto& word : s_) { word[lane] = splitmix64(seed); }
+            }
+        }
+
+        // Writes transform(bits) for count outputs to out
+        template<class Value, class Transform>
+        void generate(Value* out, std::size_t count, Transform transform) {
+            std::size_t i = 0;
+#if defined(UTILITIES_HAS_WIDE_VECTORS)
+            using Lanes = Vector<uint64_t, kLanes>;
+            Lanes s0, s1, s2, s3;
+            load(s0, s_[0]); load(s1, s_[1]); load(s2, s_[2]); load(s3, s_[3]);
+            for (; i + kLanes <= count; i += kLanes) {
+                const Lanes sum = s0 + s3;
+                const Lanes result = ((sum << 23) | (sum >> 41)) + s0;
+                const Lanes t = s1 << 17;
+                s2 ^= s0;
+                s3 ^= s1;
+                s1 ^= s2;
+                s0 ^= s3;
+                s2 ^= t;
+                s3 = (s3 << 45) | (s3 >> 19);
+                for (std::size_t lane = 0; lane < kLanes; ++lane) { out[i + lane] = transform(result[lane]); }
+            }
+            store(s_[0], s0); store(s_[1], s1); store(s_[2], s2); store(s_[3], s3);
+#endif
+            // The tail, or everything without wide vectors
+            for (std::size_t lane = 0; i < count; ++i, lane = (lane + 1) % kLanes) {
+                out[i] = transform(step(lane));
+            }
+        }
+
+    private:
+        uint64_t step(std::size_t lane) {
+            const uint64_t result = rotl(s_[0][lane] + s_[3][lane], 23) + s_[0][lane];
+            const uint64_t t = s_[1][lane] << 17;
+            s_[2][lane] ^= s_[0][lane];
+            s_[3][lane] ^= s_[1][lane];
+            s_[1][lane] ^= s_[2][lane];
+            s_[0][lane] ^= s_[3][lane];
+            s_[2][lane] ^= t;
+            s_[3][lane] = rotl(s_[3][lane], 45);
+            return result;
+        }
+
+        uint64_t s_[4][kLanes];
+    };
+}
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // xoshiro256pp - The xoshiro256++ generator. Fast, small and statistically solid.
+    // jump() advances by 2^128 outputs, so repeatedly jumping hands out independent
+    // streams, e.g. one per thread. long_jump() advances by 2^192.
+    // Satisfies the UniformRandomBitGenerator requirements.
+    ////////////////////////////////////////////////////////////////////////////////
+    class xoshiro256pp {
+    public:
+        using result_type = uint64_t;
+
+        constexpr explicit xoshiro256pp(uint64_t seed = 0x5EED) {
+            for (uint64_t& word : s_) { word = utilities::intern::splitmix64(seed); }
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+        constexpr result_type operator()() {
+            const uint64_t result = utilities::intern::rotl(s_[0] + s_[3], 23) + s_[0];
+            const uint64_t t = s_[1] << 17;
+            s_[2] ^= s_[0];
+            s_[3] ^= s_[1];
+            s_[1] ^= s_[2];
+            s_[0] ^= s_[3];
+            s_[2] ^= t;
+            s_[3] = utilities::intern::rotl(s_[3], 45);
+            return result;
+        }
+
+        constexpr void jump() {
+            constexpr uint64_t kJump[] = { 0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull,
+                                           0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull };
+            apply(kJump);
+        }
+
+        constexpr void long_jump() {
+            constexpr uint64_t kLongJump[] = { 0x76E15D3EFEFDCBBFull, 0xC5004E441C522FB3ull,
+                                               0x77710069854EE241ull, 0x39109BB02ACBE635ull };
+            apply(kLongJump);
+        }
+
+    private:
+        constexpr void apply(const uint64_t (&polynomial)[4]) {
+            uint64_t jumped[4] = {};
+            for (uint64_t word : polynomial) {
+                for (int bit = 0; bit < 64; ++bit) {
+                    if (word & (uint64_t{1} << bit)) {
+                        for (int i = 0; i < 4; ++i) { jumped[i] ^= s_[i]; }
+                    }
+                    operator()();
+                }
+            }
+            for (int i = 0; i < 4; ++i) { s_[i] = jumped[i]; }
+        }
+
+        uint64_t s_[4] = {};
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // philox4x32 - The Philox4x32-10 counter based generator. Output block n is a pure
+    // function of the key and n, so any element can be generated independently of
+    // all others. That makes results reproducible however work is split between
+    // threads, and bulk generation has no loop carried dependency, so it vectorizes.
+    // Used as an engine it walks through the blocks in order.
+    ////////////////////////////////////////////////////////////////////////////////
+    class philox4x32 {
+    public:
+        using result_type = uint64_t;
+        using Block = std::array<uint32_t, 4>;
+
+        constexpr explicit philox4x32(uint64_t key = 0x5EED, uint64_t counter = 0)
+            : key_(key)
+            , counter_(counter)
+        {
+            // Nothing
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+        // The 128 bit block for counter n
+        constexpr Block block(uint64_t n) const {
+            uint32_t c0 = static_cast<uint32_t>(n), c1 = static_cast<uint32_t>(n >> 32), c2 = 0, c3 = 0;
+            uint32_t k0 = static_cast<uint32_t>(key_), k1 = static_cast<uint32_t>(key_ >> 32);
+            for (int round = 0; round < 10; ++round) {
+                const uint64_t product0 = uint64_t{0xD2511F53} * c0;
+                const uint64_t product1 = uint64_t{0xCD9E8D57} * c2;
+                const uint32_t next0 = static_cast<uint32_t>(product1 >> 32) ^ c1 ^ k0;
+                const uint32_t next2 = static_cast<uint32_t>(product0 >> 32) ^ c3 ^ k1;
+                c1 = static_cast<uint32_t>(product1);
+                c3 = static_cast<uint32_t>(product0);
+                c0 = next0;
+                c2 = next2;
+                k0 += 0x9E3779B9u;
+                k1 += 0xBB67AE85u;
+            }
+            return {c0, c1, c2, c3};
+        }
+
+        // The index-th 64 bit output of this key
+        constexpr uint64_t at(uint64_t index) const {
+            const Block b = block(index >> 1);
+            return (index & 1) ? (uint64_t{b[3]} << 32 | b[2]) : (uint64_t{b[1]} << 32 | b[0]);
+        }
+
+        constexpr result_type operator()() { return at(counter_++); }
+
+        // Writes outputs [first_index, first_index + count) to out
+        void fill(uint64_t* out, std::size_t count, uint64_t first_index = 0) const {
+            for (std::size_t i = 0; i < count; ++i) { out[i] = at(first_index + i); }
+        }
+
+        constexpr uint64_t key() const { return key_; }
+        constexpr uint64_t counter() const { return counter_; }
+
+    private:
+        uint64_t key_;
+        uint64_t counter_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // alias_table - Walker's alias method. Built in O(n) from non negative weights,
+    // after which every weighted draw is O(1): one uniform index and one compare.
+    ////////////////////////////////////////////////////////////////////////////////
+    class alias_table {
+    public:
+        alias_table() = default;
+
+        template<class Weights>
+        explicit alias_table(const Weights& weights) {
+            const std::size_t n = static_cast<std::size_t>(std::size(weights));
+            double total = 0;
+            for (const auto& weight : weights) {
+                if (!(weight >= 0)) { throw std::invalid_argument("alias_table: weights must be non negative"); }
+                total += static_cast<double>(weight);
+            }
+            if (n == 0 || !(total > 0)) { throw std::invalid_argument("alias_table: total weight must be positive"); }
+
+            probability_.resize(n);
+            alias_.resize(n);
+            std::vector<double> scaled;
+            scaled.reserve(n);
+            for (const auto& weight : weights) { scaled.push_back(static_cast<double>(weight) * n / total); }
+
+            std::vector<uint32_t> small, large;
+            for (std::size_t i = 0; i < n; ++i) { (scaled[i] < 1 ? small : large).push_back(static_cast<uint32_t>(i)); }
+            while (!small.empty() && !large.empty()) {
+                const uint32_t less = small.back(); small.pop_back();
+                const uint32_t more = large.back();
+                probability_[less] = scaled[less];
+                alias_[less] = more;
+                scaled[more] -= 1 - scaled[less];
+                if (scaled[more] < 1) { large.pop_back(); small.push_back(more); }
+            }
+            // Leftovers are 1 up to rounding
+            for (uint32_t i : large) { probability_[i] = 1; alias_[i] = i; }
+            for (uint32_t i : small) { probability_[i] = 1; alias_[i] = i; }
+        }
+
+        std::size_t size() const { return probability_.size(); }
+
+        // Draws an index with two values from a UniformRandomBitGenerator producing 64 bits
+        template<class Generator>
+        std::size_t operator()(Generator& generator) const {
+            uint64_t low;
+            const auto column = static_cast<std::size_t>(utilities::intern::multiply_wide(generator(), size(), low));
+            return utilities::intern::to_unit_double(generator()) < probability_[column] ? column : alias_[column];
+        }
+
+    private:
+        std::vector<double> probability_;
+        std::vector<uint32_t> alias_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // rng - Python random module style interface on top of an engine
+    //      rng<> r{42};
+    //      double x = r.random();          // [0, 1)
+    //      int64_t d = r.randint(1, 6);    // [1, 6], both inclusive
+    //      auto picks = r.choices(names, weights, 10);
+    //
+    // Per thread streams: rng<>::stream(seed, thread_index) jumps the seed's stream
+    // thread_index times, so the threads never overlap. For results that don't
+    // depend on the number of threads either, use rng<philox4x32> and the *_at
+    // functions, which derive the value for element i from i alone.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Engine = xoshiro256pp>
+    class rng {
+    public:
+        constexpr explicit rng(uint64_t seed = 0x5EED) : engine_(seed) { }
+        constexpr explicit rng(const Engine& engine) : engine_(engine) { }
+
+        static rng stream(uint64_t seed, int64_t stream_index) {
+            rng result{seed};
+            for (int64_t i = 0; i < stream_index; ++i) { result.engine_.jump(); }
+            return result;
+        }
+
+        Engine& engine() { return engine_; }
+        void jump() { engine_.jump(); }
+
+    public:
+        //------------------------------------------------------------------------------
+        // Single values
+        // random - uniform double in [0, 1)
+        // uniform - uniform double in [a, b)
+        // randint - uniform integer in [a, b], unbiased (Lemire's multiply and reject),
+        //           throws if b < a like Python
+        // randbelow - uniform integer in [0, n)
+        // gauss - normal distribution, Marsaglia's polar method with the spare cached
+        //------------------------------------------------------------------------------
+        double random() { return utilities::intern::to_unit_double(engine_()); }
+        double uniform(double a, double b) { return a + (b - a) * random(); }
+        int64_t randint(int64_t a, int64_t b) {
+            if (b < a) { throw std::invalid_argument("randint: empty range"); }
+            // In unsigned arithmetic, where the full 64 bit range wraps to 0 instead of overflowing
+            return static_cast<int64_t>(static_cast<uint64_t>(a) + randbelow(static_cast<uint64_t>(b) - static_cast<uint64_t>(a) + 1));
+        }
+
+        uint64_t randbelow(uint64_t n) {
+            if (n == 0) { return engine_(); }  // randint over the full 64 bit range
+            uint64_t low;
+            uint64_t high = utilities::intern::multiply_wide(engine_(), n, low);
+            if (low < n) {
+                const uint64_t threshold = (0 - n) % n;
+                while (low < threshold) { high = utilities::intern::multiply_wide(engine_(), n, low); }
+            }
+            return high;
+        }
+
+        double gauss(double mu = 0, double sigma = 1) {
+            if (has_spare_) {
+                has_spare_ = false;
+                return mu + sigma * spare_;
+            }
+            double u, v, s;
+            do {
+                u = 2 * random() - 1;
+                v = 2 * random() - 1;
+                s = u * u + v * v;
+            } while (s >= 1 || s == 0);
+            const double factor = std::sqrt(-2 * std::log(s) / s);
+            spare_ = v * factor;
+            has_spare_ = true;
+            return mu + sigma * u * factor;
+        }
+
+    public:
+        //------------------------------------------------------------------------------
+        // choices - k elements of population drawn with replacement, weighted through
+        // an alias table. Build the alias_table once and call the overload taking it
+        // when drawing from the same weights repeatedly.
+        //------------------------------------------------------------------------------
+        template<class Population, class Weights>
+        auto choices(const Population& population, const Weights& weights, std::size_t k) {
+            return choices(population, alias_table{weights}, k);
+        }
+
+        template<class Population>
+        auto choices(const Population& population, const alias_table& table, std::size_t k) {
+            using Value = std::decay_t<decltype(*std::begin(population))>;
+            if (table.size() != static_cast<std::size_t>(std::size(population))) {
+                throw std::invalid_argument("choices: population and weights differ in size");
+            }
+            std::vector<Value> result;
+            result.reserve(k);
+            for (std::size_t i = 0; i < k; ++i) { result.push_back(*std::next(std::begin(population), table(engine_))); }
+            return result;
+        }
+
+    public:
+        //------------------------------------------------------------------------------
+        // shuffle - Fisher-Yates shuffle of a container or iterator range in place
+        // parallel_shuffle - MergeShuffle for large containers with random access: the
+        //                    blocks are shuffled on separate threads, each with its own
+        //                    jumped xoshiro256++ stream, and then merged pairwise, which
+        //                    keeps every permutation equally likely. Small containers are
+        //                    shuffled by the calling thread.
+        //------------------------------------------------------------------------------
+        template<class Iterator>
+        void shuffle(Iterator first, Iterator last) {
+            for (auto i = last - first - 1; i > 0; --i) {
+                std::iter_swap(first + i, first + static_cast<decltype(i)>(randbelow(static_cast<uint64_t>(i) + 1)));
+            }
+        }
+
+        template<class Container>
+        void shuffle(Container& container) { shuffle(std::begin(container), std::end(container)); }
+
+        template<class Container>
+        void parallel_shuffle(Container& container, int64_t threads = utilities::intern::hardware_threads()) {
+            constexpr int64_t kMinBlock = 1 << 16;
+            const auto first = std::begin(container);
+            const auto count = static_cast<int64_t>(std::end(container) - first);
+
+            int64_t blocks = 1;
+            while (blocks < threads && blocks * 2 * kMinBlock <= count) { blocks *= 2; }
+            if (blocks == 1) { shuffle(container); return; }
+
+            std::vector<rng<xoshiro256pp>> streams;
+            streams.reserve(blocks);
+            xoshiro256pp engine{engine_()};
+            for (int64_t block = 0; block < blocks; ++block) {
+                streams.emplace_back(engine);
+                engine.jump();
+            }
+
+            auto bound = [&](int64_t block) { return first + count * block / blocks; };
+            utilities::intern::parallel_tasks(blocks, [&](int64_t block) {
+                streams[block].shuffle(bound(block), bound(block + 1));
+            }, threads);
+            // A merge uses the stream of its leftmost block, which nothing else touches meanwhile
+            for (int64_t width = 1; width < blocks; width *= 2) {
+                utilities::intern::parallel_tasks(blocks / (2 * width), [&](int64_t pair) {
+                    const int64_t block = pair * 2 * width;
+                    merge_shuffled(bound(block), bound(block + width) - bound(block),
+                                   bound(block + 2 * width) - bound(block), streams[block]);
+                }, threads);
+            }
+        }
+
+    public:
+        //------------------------------------------------------------------------------
+        // sample - k distinct elements of population, in random order. Works on any
+        // iterable including generators and single pass streams, whose length needn't
+        // be known. Reservoir sampling with Li's Algorithm L draws the gaps between
+        // replaced elements, so only O(k (1 + log(n / k))) random numbers are needed;
+        // skipped elements are merely stepped over, or jumped over with random access.
+        // Elements of enumerate and zip are stored as std::tuples of values.
+        //------------------------------------------------------------------------------
+        template<class Population>
+        auto sample(Population&& population, std::size_t k) {
+            using utilities::intern::materialize;
+            using Value = decltype(materialize(*std::begin(population)));
+            std::vector<Value> reservoir;
+            reservoir.reserve(k);
+
+            auto it = std::begin(population);
+            const auto end = std::end(population);
+            for (; reservoir.size() < k && it != end; ++it) { reservoir.push_back(materialize(*it)); }
+            if (reservoir.size() < k) { throw std::invalid_argument("sample: sample larger than population"); }
+            if (k == 0) { return reservoir; }
+
+            double w = std::exp(std::log(random_open()) / k);
+            for (;;) {
+                const double gap = std::floor(std::log(random_open()) / std::log1p(-w));
+                const int64_t gap_elements = gap < 9e18 ? static_cast<int64_t>(gap) : std::numeric_limits<int64_t>::max();
+                if (!utilities::intern::skip(it, end, gap_elements)) { break; }
+                reservoir[randbelow(k)] = materialize(*it);
+                ++it;
+                w *= std::exp(std::log(random_open()) / k);
+            }
+            // The reservoir holds the survivors in order of arrival
+            shuffle(reservoir);
+            return reservoir;
+        }
+
+    public:
+        //------------------------------------------------------------------------------
+        // Bulk generation into contiguous storage of doubles (fill_random, fill_uniform)
+        // or uint64_t (fill_bits), e.g. columns that are then zipped.
+        // Each call seeds a set of xoshiro256++ lanes from one engine output and lets
+        // them generate side by side, which vectorizes.
+        //------------------------------------------------------------------------------
+        template<class Container>
+        void fill_random(Container& out) {
+            utilities::intern::XoshiroLanes lanes{engine_()};
+            lanes.generate(std::data(out), std::size(out), utilities::intern::to_unit_double);
+        }
+
+        template<class Container>
+        void fill_uniform(Container& out, double a, double b) {
+            utilities::intern::XoshiroLanes lanes{engine_()};
+            const double scale = b - a;
+            lanes.generate(std::data(out), std::size(out), [a, scale](uint64_t bits) {
+                return a + scale * utilities::intern::to_unit_double(bits);
+            });
+        }
+
+        template<class Container>
+        void fill_bits(Container& out) {
+            utilities::intern::XoshiroLanes lanes{engine_()};
+            lanes.generate(std::data(out), std::size(out), [](uint64_t bits) { return bits; });
+        }
+
+    public:
+        //------------------------------------------------------------------------------
+        // Counter based access - only for rng<philox4x32>. Element index of the stream
+        // is always the same value, regardless of which thread asks for it.
+        //------------------------------------------------------------------------------
+        double random_at(uint64_t index) const { return utilities::intern::to_unit_double(engine_.at(index)); }
+        double uniform_at(uint64_t index, double a, double b) const { return a + (b - a) * random_at(index); }
+
+    private:
+        // Uniform double in (0, 1), safe to take the log of
+        double random_open() { return (static_cast<double>(static_cast<int64_t>(engine_() >> 11)) + 0.5) * 0x1.0p-53; }
+
+        // Merges two shuffled halves [0, middle) and [middle, count) into a shuffled
+        // whole: a coin flip per position picks which half it's taken from, and once
+        // a half runs out the remainder is inserted at random positions
+        template<class Iterator, class Stream>
+        static void merge_shuffled(Iterator first, int64_t middle, int64_t count, Stream& stream) {
+            int64_t i = 0, j = middle;
+            uint64_t bits = 0;
+            int available = 0;
+            for (;; ++i) {
+                if (available == 0) { bits = stream.engine()(); available = 64; }
+                const bool from_right = bits & 1;
+                bits >>= 1;
+                --available;
+                if (from_right) {
+                    if (j == count) { break; }
+                    std::iter_swap(first + i, first + j++);
+                } else if (i == j) {
+                    break;
+                }
+            }
+            for (; i < count; ++i) { std::iter_swap(first + i, first + static_cast<int64_t>(stream.randbelow(i + 1))); }
+        }
+
+        Engine engine_;
+        double spare_ = 0;
+        bool has_spare_ = false;
+    };
+}
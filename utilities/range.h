@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <type_traits>
+#include <utility>
 #include "generator_iterator.h"
 
 namespace utilities::intern {
@@ -45,6 +48,52 @@ namespace utilities::intern {
         constexpr Generator(Generator&&) = delete;
         constexpr Generator& operator=(const Generator&) = delete;
         constexpr Generator& operator=(Generator&&) = delete;
+
+    public:
+        //------------------------------------------------------------------------------
+        // Loop probe - Only present when loop instrumentation is enabled
+        //------------------------------------------------------------------------------
+        UTILITIES_LOOP_PROBE
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // TakenGenerator - The implementation of a temporary Generator moved out of it.
+    // Generators can't be moved, so functions that return a generator of their own
+    // keep the state of a Generator argument this way, like reversed does for range.
+    // Its loop is reported at the site of the temporary, which reports none itself.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Impl>
+    class TakenGenerator : public Impl {
+    public:
+        explicit TakenGenerator(Generator<Impl>&& generator)
+            : Impl(std::move(static_cast<Impl&>(generator)))
+            UTILITIES_LOOP_PROBE_FROM(UTILITIES_LOOP_FORGET(generator))
+        {
+            // Nothing
+        }
+
+        using Iterator = GeneratorIterator<TakenGenerator>;
+        Iterator begin() { return Iterator(*this); }
+        GeneratorEnd end() { return {}; }
+
+        UTILITIES_LOOP_PROBE
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Kept - How a function returning a generator keeps an argument: like Owned, but
+    // temporary Generators become TakenGenerators. kValid is false for temporaries
+    // that can't be kept, which can only be passed as lvalues.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable>
+    struct Kept {
+        using type = Owned<Iterable>;
+        static constexpr bool kValid = !std::is_rvalue_reference_v<Iterable> || std::is_move_constructible_v<std::remove_reference_t<Iterable>>;
+    };
+
+    template<class Impl>
+    struct Kept<Generator<Impl>&&> {
+        using type = TakenGenerator<Impl>;
+        static constexpr bool kValid = std::is_move_constructible_v<Impl>;
     };
 }
 
@@ -74,6 +123,19 @@ namespace {
         constexpr RangeImpl& operator++() { val_ += step_; return *this; }
         constexpr explicit operator bool() const { return (val_ * comparison_mod_) < modded_end_; }
 
+    public:
+        //------------------------------------------------------------------------------
+        // size - The number of values that are still to be generated
+        // step - The difference between consecutive values
+        //------------------------------------------------------------------------------
+        constexpr int64_t size() const {
+            const int64_t remaining = modded_end_ - val_ * comparison_mod_;
+            const int64_t abs_step = step_ * comparison_mod_;
+            return remaining <= 0 ? 0 : (remaining + abs_step - 1) / abs_step;
+        }
+
+        constexpr int64_t step() const { return step_; }
+
     private:
         //------------------------------------------------------------------------------
         // Member Variables
@@ -95,15 +157,15 @@ namespace {
     //      range(begin, end) - step is 1
     //      range(begin, end, step) - begin is 0 and step is 1
     ////////////////////////////////////////////////////////////////////////////////
-    constexpr Range range(int64_t end) {
-        return Range{{0, end, 1}};
+    UTILITIES_LOOP_CONSTEXPR Range range(int64_t end UTILITIES_LOOP_SITE_PARAMS) {
+        return Range{{0, end, 1} UTILITIES_LOOP_SITE_ARGS};
     }
 
-    constexpr Range range(int64_t begin, int64_t end) {
-        return Range{{begin, end, 1}};
+    UTILITIES_LOOP_CONSTEXPR Range range(int64_t begin, int64_t end UTILITIES_LOOP_SITE_PARAMS) {
+        return Range{{begin, end, 1} UTILITIES_LOOP_SITE_ARGS};
     }
 
-    constexpr Range range(int64_t begin, int64_t end, int64_t step) {
-        return Range{{begin, end, step}};
+    UTILITIES_LOOP_CONSTEXPR Range range(int64_t begin, int64_t end, int64_t step UTILITIES_LOOP_SITE_PARAMS) {
+        return Range{{begin, end, step} UTILITIES_LOOP_SITE_ARGS};
     }
 }
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "generator_iterator.h"
+#include "range.h"
+#include "enumerate.h"
+#include "zip.h"
+
+namespace utilities::intern {
+    template<class Iterable, class = void>
+    struct IsReversible : std::false_type {};
+
+    template<class Iterable>
+    struct IsReversible<Iterable, std::void_t<decltype(std::rbegin(std::declval<Iterable&>()))>> : std::true_type {};
+}
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // ReversedContainer - A container iterated back to front through its reverse
+    // iterators, which for contiguous containers are plain pointer decrements
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable>
+    struct ReversedContainer {
+        Iterable iterable_;
+
+        constexpr auto begin() { return std::rbegin(iterable_); }
+        constexpr auto end() { return std::rend(iterable_); }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ReversedEnumerate - enumerate back to front, the indices count down from
+    // start + size - 1
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable>
+    class ReversedEnumerate {
+    public:
+        //------------------------------------------------------------------------------
+        // Initialization variables - Can only be set via aggregate initialization
+        //------------------------------------------------------------------------------
+        Iterable iterable_;
+        int64_t starting_idx_ = 0;
+        UTILITIES_LOOP_PROBE
+
+    public:
+        //------------------------------------------------------------------------------
+        // State of the generator - It's public to allow for aggregate initialization of
+        // the above variables, but this should be treated as private.
+        //------------------------------------------------------------------------------
+        using State = EnumerateState<decltype(std::rbegin(iterable_))>;
+        State state_{starting_idx_ + static_cast<int64_t>(std::size(iterable_)) - 1, std::rbegin(iterable_)};
+
+    public:
+        //------------------------------------------------------------------------------
+        // Implicit Constructors - All Deleted
+        //------------------------------------------------------------------------------
+        constexpr ReversedEnumerate() = delete;
+        constexpr ReversedEnumerate(const ReversedEnumerate&) = delete;
+        constexpr ReversedEnumerate(ReversedEnumerate&&) = delete;
+        constexpr ReversedEnumerate& operator=(const ReversedEnumerate&) = delete;
+        constexpr ReversedEnumerate& operator=(ReversedEnumerate&&) = delete;
+
+    public:
+        //------------------------------------------------------------------------------
+        // Begin and End - Enables usage in ranged-for
+        //------------------------------------------------------------------------------
+        using Iterator = utilities::intern::GeneratorIterator<ReversedEnumerate>;
+        constexpr Iterator begin() { return Iterator{*this}; }
+        constexpr utilities::intern::GeneratorEnd end() { return {}; }
+
+    public:
+        //------------------------------------------------------------------------------
+        // operators - Emulating the generator class's operators
+        //------------------------------------------------------------------------------
+        constexpr State& operator*() { return state_; }
+        constexpr ReversedEnumerate& operator++() { --state_.idx_; ++state_.iter_; return *this; }
+        constexpr explicit operator bool() const { return state_.iter_ != std::rend(iterable_); }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ReversedZipState - This represents the state of a reversed zip. Every iterable
+    // starts at the last row zip would yield, so the rows of unequal length inputs
+    // line up as they do going forward. Only the rows left are checked per step.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class... Iterables>
+    struct ReversedZipState {
+        using Storage = std::tuple<Iterables...>;
+
+        // Construct from the reversed zip's iterables
+        explicit constexpr ReversedZipState(Storage& iterables)
+            : ReversedZipState(iterables, std::index_sequence_for<Iterables...>{})
+        {
+            // Nothing
+        }
+
+        // Increment all iterators
+        constexpr void operator++() {
+            std::apply([](auto&... iterators) { (++iterators, ...); }, iterators_);
+            --remaining_;
+        }
+        constexpr bool can_advance() const { return remaining_ > 0; }
+
+        // Enables structured bindings
+        template <std::size_t N>
+        constexpr decltype(auto) get() const { return *std::get<N>(iterators_); }
+
+        // Member Variables
+        using Iterators = std::tuple<std::reverse_iterator<decltype(std::begin(std::declval<Iterables&>()))>...>;
+        int64_t remaining_;
+        Iterators iterators_;
+
+    private:
+        template<size_t... Is>
+        constexpr ReversedZipState(Storage& iterables, std::index_sequence<Is...>)
+            : remaining_(std::min({static_cast<int64_t>(std::size(std::get<Is>(iterables)))...}))
+            , iterators_(std::make_reverse_iterator(std::next(std::begin(std::get<Is>(iterables)), remaining_))...)
+        {
+            // Nothing
+        }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ReversedZip - zip back to front
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class... Iterables>
+    class ReversedZip {
+    public:
+        //------------------------------------------------------------------------------
+        // Initialization variables - Can only be set via aggregate initialization
+        //------------------------------------------------------------------------------
+        std::tuple<Iterables...> iterables_;
+        UTILITIES_LOOP_PROBE
+
+    public:
+        //------------------------------------------------------------------------------
+        // State of the generator - It's public to allow for aggregate initialization of
+        // the above variables, but this should be treated as private.
+        //------------------------------------------------------------------------------
+        using State = ReversedZipState<Iterables...>;
+        State state_{iterables_};
+
+    public:
+        //------------------------------------------------------------------------------
+        // Implicit Constructors - All Deleted
+        //------------------------------------------------------------------------------
+        constexpr ReversedZip() = delete;
+        constexpr ReversedZip(const ReversedZip&) = delete;
+        constexpr ReversedZip(ReversedZip&&) = delete;
+        constexpr ReversedZip& operator=(const ReversedZip&) = delete;
+        constexpr ReversedZip& operator=(ReversedZip&&) = delete;
+
+    public:
+        //------------------------------------------------------------------------------
+        // Begin and End - Enables usage in ranged-for
+        //------------------------------------------------------------------------------
+        using Iterator = utilities::intern::GeneratorIterator<ReversedZip>;
+        constexpr Iterator begin() { return Iterator{*this}; }
+        constexpr utilities::intern::GeneratorEnd end() { return {}; }
+
+    public:
+        //------------------------------------------------------------------------------
+        // operators - Emulating the generator class's operators
+        //------------------------------------------------------------------------------
+        constexpr State& operator*() { return state_; }
+        constexpr ReversedZip& operator++() { ++state_; return *this; }
+        constexpr explicit operator bool() const { return state_.can_advance(); }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // reversed - Like Python's reversed, iterates back to front without copying.
+    //      reversed(range(2, 11, 3)) - a range with the reversed bounds: 8, 5, 2
+    //      reversed(enumerate{ vec }) - indices count down from vec.size() - 1
+    //      reversed(zip{ a, b }) - the rows zip{ a, b } yields, last one first, also
+    //                              when a and b differ in length
+    //      reversed(vec) - any container with reverse iterators
+    // enumerate and zip need iterables with a size and bidirectional iterators.
+    // Temporaries are moved into the result, lvalues are referred to. A temporary
+    // generator isn't iterated itself, so its loop isn't reported.
+    ////////////////////////////////////////////////////////////////////////////////
+    UTILITIES_LOOP_CONSTEXPR Range reversed(Range& forward UTILITIES_LOOP_SITE_PARAMS) {
+        const int64_t first = *forward;
+        const int64_t step = forward.step();
+        const int64_t last = first + (forward.size() - 1) * step;
+        return Range{{last, first - step, -step} UTILITIES_LOOP_SITE_ARGS};
+    }
+
+    UTILITIES_LOOP_CONSTEXPR Range reversed(Range&& forward UTILITIES_LOOP_SITE_PARAMS) {
+        UTILITIES_LOOP_FORGET(forward);
+        const int64_t first = *forward;
+        const int64_t step = forward.step();
+        const int64_t last = first + (forward.size() - 1) * step;
+        return Range{{last, first - step, -step} UTILITIES_LOOP_SITE_ARGS};
+    }
+
+    template<class Iterable>
+    auto reversed(enumerate<Iterable>& forward UTILITIES_LOOP_SITE_PARAMS) {
+        return ReversedEnumerate<std::remove_reference_t<Iterable>&>{forward.iterable_, forward.starting_idx_ UTILITIES_LOOP_SITE_ARGS};
+    }
+
+    template<class Iterable>
+    auto reversed(enumerate<Iterable>&& forward UTILITIES_LOOP_SITE_PARAMS) {
+        UTILITIES_LOOP_FORGET(forward);
+        return ReversedEnumerate<utilities::intern::Owned<Iterable>>{static_cast<Iterable&&>(forward.iterable_), forward.starting_idx_ UTILITIES_LOOP_SITE_ARGS};
+    }
+
+    template<class... Iterables>
+    auto reversed(zip<Iterables...>& forward UTILITIES_LOOP_SITE_PARAMS) {
+        return std::apply([&](auto&... iterables) {
+            return ReversedZip<std::remove_reference_t<Iterables>&...>{{iterables...} UTILITIES_LOOP_SITE_ARGS};
+        }, utilities::intern::zip_iterables(forward));
+    }
+
+    template<class... Iterables>
+    auto reversed(zip<Iterables...>&& forward UTILITIES_LOOP_SITE_PARAMS) {
+        UTILITIES_LOOP_FORGET(forward);
+        return std::apply([&](auto&... iterables) {
+            return ReversedZip<utilities::intern::Owned<Iterables>...>{{static_cast<Iterables&&>(iterables)...} UTILITIES_LOOP_SITE_ARGS};
+        }, utilities::intern::zip_iterables(forward));
+    }
+
+    template<class Iterable, class = std::enable_if_t<utilities::intern::IsReversible<Iterable>::value>>
+    ReversedContainer<utilities::intern::Owned<Iterable&&>> reversed(Iterable&& iterable) {
+        return {std::forward<Iterable>(iterable)};
+    }
+}
+
+// Need to do this since array and tuple define tuple_element and tuple_size as a class and a struct
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wmismatched-tags"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// tuple_element and tuple_size specializations for ReversedZipState's structured bindings
+////////////////////////////////////////////////////////////////////////////////
+namespace std {
+    template<std::size_t N, class... Iterables>
+    struct tuple_element<N, ReversedZipState<Iterables...>> {
+        using type = decltype(std::declval<ReversedZipState<Iterables...>>().template get<N>());
+    };
+
+    template<class... Iterables>
+    struct tuple_size<ReversedZipState<Iterables...>> : std::integral_constant<std::size_t, sizeof...(Iterables)> {
+        // Empty
+    };
+}
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
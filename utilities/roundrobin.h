@@ -0,0 +1,338 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "generator_iterator.h"
+#include "span.h"
+#include "zip.h"
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // RoundrobinRing - The order in which the inputs take turns, as a circular doubly
+    // linked list over their indices, so an exhausted input is unlinked in O(1) and
+    // never visited again
+    ////////////////////////////////////////////////////////////////////////////////
+    template<std::size_t Count>
+    struct RoundrobinRing {
+        constexpr RoundrobinRing() {
+            for (std::size_t i = 0; i < Count; ++i) {
+                next_[i] = (i + 1) % Count;
+                previous_[i] = (i + Count - 1) % Count;
+            }
+        }
+
+        // Unlinks the current input and moves on to the next one, false if none is left
+        constexpr bool remove_current() {
+            if (next_[current_] == current_) { return false; }
+            next_[previous_[current_]] = next_[current_];
+            previous_[next_[current_]] = previous_[current_];
+            current_ = next_[current_];
+            return true;
+        }
+
+        constexpr void advance() { current_ = next_[current_]; }
+
+        std::array<std::size_t, Count> next_{};
+        std::array<std::size_t, Count> previous_{};
+        std::size_t current_ = 0;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // RoundrobinState - The state of roundrobin and interleave for any iterables.
+    // The iterators live in a tuple and are reached through tables of functions
+    // indexed by the current input. Longest decides between skipping exhausted
+    // inputs (roundrobin) and stopping before the first round that one of them
+    // can't complete (interleave).
+    ////////////////////////////////////////////////////////////////////////////////
+    template<bool Longest, class... Iterables>
+    struct RoundrobinState {
+        static constexpr std::size_t kCount = sizeof...(Iterables);
+        using Storage = ZipStorage<0, Iterables...>;
+        using Iterators = std::tuple<decltype(std::begin(std::declval<Iterables&>()))...>;
+        using Ends = std::tuple<decltype(std::end(std::declval<Iterables&>()))...>;
+        using References = std::tuple<decltype(*std::begin(std::declval<Iterables&>()))...>;
+        using Reference = std::conditional_t<(std::is_same_v<std::tuple_element_t<0, References>, decltype(*std::begin(std::declval<Iterables&>()))> && ...),
+                                             std::tuple_element_t<0, References>,
+                                             std::common_type_t<std::decay_t<decltype(*std::begin(std::declval<Iterables&>()))>...>>;
+
+        // Construct from a ZipStorage holding the iterables
+        explicit constexpr RoundrobinState(Storage& storage)
+            : RoundrobinState(storage, std::index_sequence_for<Iterables...>{})
+        {
+            // Nothing
+        }
+
+        constexpr Reference current() { return kDereference[ring_.current_](iterators_); }
+
+        // Moves on to the next input's element
+        constexpr void advance() {
+            kIncrement[ring_.current_](iterators_);
+            ring_.advance();
+            settle();
+        }
+
+        constexpr bool can_advance() const { return !done_; }
+
+    private:
+        template<std::size_t... Is>
+        constexpr RoundrobinState(Storage& storage, std::index_sequence<Is...>)
+            : iterators_(std::begin(zip_storage_at<Is>(storage).iterable)...)
+            , ends_(std::end(zip_storage_at<Is>(storage).iterable)...)
+        {
+            settle();
+        }
+
+        // roundrobin skips past exhausted inputs, unlinking them. interleave checks
+        // all inputs at the start of a round, so it only yields complete rounds.
+        constexpr void settle() {
+            if constexpr (Longest) {
+                while (kExhausted[ring_.current_](iterators_, ends_)) {
+                    if (!ring_.remove_current()) {
+                        done_ = true;
+                        return;
+                    }
+                }
+            } else if (ring_.current_ == 0) {
+                for (std::size_t input = 0; input < kCount && !done_; ++input) { done_ = kExhausted[input](iterators_, ends_); }
+            }
+        }
+
+        template<std::size_t I>
+        static constexpr Reference dereference(Iterators& iterators) { return *std::get<I>(iterators); }
+
+        template<std::size_t I>
+        static constexpr void increment(Iterators& iterators) { ++std::get<I>(iterators); }
+
+        template<std::size_t I>
+        static constexpr bool exhausted(const Iterators& iterators, const Ends& ends) { return !(std::get<I>(iterators) != std::get<I>(ends)); }
+
+        template<std::size_t... Is>
+        static constexpr auto dereference_table(std::index_sequence<Is...>) { return std::array<Reference (*)(Iterators&), kCount>{&dereference<Is>...}; }
+
+        template<std::size_t... Is>
+        static constexpr auto increment_table(std::index_sequence<Is...>) { return std::array<void (*)(Iterators&), kCount>{&increment<Is>...}; }
+
+        template<std::size_t... Is>
+        static constexpr auto exhausted_table(std::index_sequence<Is...>) { return std::array<bool (*)(const Iterators&, const Ends&), kCount>{&exhausted<Is>...}; }
+
+        static constexpr auto kDereference = dereference_table(std::index_sequence_for<Iterables...>{});
+        static constexpr auto kIncrement = increment_table(std::index_sequence_for<Iterables...>{});
+        static constexpr auto kExhausted = exhausted_table(std::index_sequence_for<Iterables...>{});
+
+        Iterators iterators_;
+        Ends ends_;
+        RoundrobinRing<kCount> ring_;
+        bool done_ = false;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ContiguousRoundrobinState - The state of roundrobin and interleave for
+    // arithmetic values of one type in contiguous storage. The rows every input
+    // still has, up to the shortest length, are interleaved a buffer at a time in
+    // a loop over rows and inputs that compilers turn into vector unpacks. That is
+    // all of interleave. For roundrobin the rest, if the lengths differ, goes
+    // through the ring one value at a time.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<bool Longest, class T, std::size_t Count>
+    struct ContiguousRoundrobinState {
+        static constexpr int64_t kRows = 1024 / Count + 1;
+        using Reference = const T&;
+
+        template<class Storage>
+        explicit ContiguousRoundrobinState(Storage& storage)
+            : ContiguousRoundrobinState(storage, std::make_index_sequence<Count>{})
+        {
+            // Nothing
+        }
+
+        Reference current() const { return buffer_[index_]; }
+
+        void advance() { if (++index_ == filled_) { refill(); } }
+
+        bool can_advance() const { return index_ < filled_; }
+
+    private:
+        template<class Storage, std::size_t... Is>
+        ContiguousRoundrobinState(Storage& storage, std::index_sequence<Is...>)
+            : positions_{std::data(zip_storage_at<Is>(storage).iterable)...}
+            , lasts_{(std::data(zip_storage_at<Is>(storage).iterable) + std::size(zip_storage_at<Is>(storage).iterable))...}
+            , bulk_rows_(std::min({static_cast<int64_t>(std::size(zip_storage_at<Is>(storage).iterable))...}))
+        {
+            refill();
+        }
+
+        void refill() {
+            index_ = 0;
+            filled_ = 0;
+            if (bulk_rows_ > 0) {
+                const int64_t rows = std::min(bulk_rows_, kRows);
+                interleave_rows(buffer_.data(), positions_, rows);
+                for (const T*& position : positions_) { position += rows; }
+                bulk_rows_ -= rows;
+                filled_ = rows * static_cast<int64_t>(Count);
+                return;
+            }
+            if constexpr (!Longest) { return; }
+
+            for (; filled_ < static_cast<int64_t>(buffer_.size()) && !done_; ring_.advance()) {
+                while (positions_[ring_.current_] == lasts_[ring_.current_]) {
+                    if (!ring_.remove_current()) {
+                        done_ = true;
+                        return;
+                    }
+                }
+                buffer_[filled_++] = *positions_[ring_.current_]++;
+            }
+        }
+
+        // The restrict qualified output and the copied pointers let compilers vectorize
+        static void interleave_rows(T* __restrict out, const std::array<const T*, Count> sources, const int64_t rows) {
+            for (int64_t row = 0; row < rows; ++row) {
+                for (std::size_t input = 0; input < Count; ++input) { out[row * Count + input] = sources[input][row]; }
+            }
+        }
+
+        std::array<const T*, Count> positions_;
+        std::array<const T*, Count> lasts_;
+        int64_t bulk_rows_;
+        RoundrobinRing<Count> ring_;
+        bool done_ = false;
+        std::array<T, kRows * Count> buffer_;
+        int64_t index_ = 0;
+        int64_t filled_ = 0;
+    };
+
+    template<bool Longest, class First, class... Iterables>
+    struct RoundrobinStateFor {
+        using Value = typename ContiguousValue<First>::type;
+        static constexpr bool kContiguous = std::is_arithmetic_v<Value> && (std::is_same_v<Value, typename ContiguousValue<Iterables>::type> && ...);
+        using type = std::conditional_t<kContiguous,
+                                        ContiguousRoundrobinState<Longest, Value, 1 + sizeof...(Iterables)>,
+                                        RoundrobinState<Longest, First, Iterables...>>;
+    };
+
+    template<bool Longest, class... Iterables>
+    using RoundrobinStateOf = typename RoundrobinStateFor<Longest, Iterables...>::type;
+}
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // roundrobin - Like the itertools roundrobin recipe: yields an element of each
+    // iterable in turn, skipping those that are exhausted, until all are.
+    // interleave - Like more_itertools' interleave: the same, but it stops once one
+    // of the iterables is exhausted, yielding only complete rounds, like zip.
+    //      for (float sample : interleave{ in_phase, quadrature }) { }    // I0 Q0 I1 Q1 ...
+    //      for (auto&& job : roundrobin{ queue_a, queue_b, queue_c }) { }
+    // Numbers of one type in contiguous storage are interleaved in bulk, and yielded
+    // by const reference. The elements of other iterables are yielded as they are
+    // when all iterables yield the same type, as their common type otherwise.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class... Iterables>
+    class roundrobin {
+    public:
+        //------------------------------------------------------------------------------
+        // Initialization variables - Can only be set via aggregate initialization
+        //------------------------------------------------------------------------------
+        using Storage = ZipStorage<0, Iterables...>;
+        Storage storage_;
+
+    public:
+        //------------------------------------------------------------------------------
+        // State of the generator - It's public to allow for aggregate initialization of
+        // the above variables, but this should be treated as private.
+        //------------------------------------------------------------------------------
+        using State = utilities::intern::RoundrobinStateOf<true, Iterables...>;
+        State state_{storage_};
+        UTILITIES_LOOP_PROBE
+
+    public:
+        //------------------------------------------------------------------------------
+        // Implicit Constructors - All Deleted
+        //------------------------------------------------------------------------------
+        constexpr roundrobin() = delete;
+        constexpr roundrobin(const roundrobin&) = delete;
+        constexpr roundrobin(roundrobin&&) = delete;
+        constexpr roundrobin& operator=(const roundrobin&) = delete;
+        constexpr roundrobin& operator=(roundrobin&&) = delete;
+
+    public:
+        //------------------------------------------------------------------------------
+        // Begin and End - Enables usage in ranged-for
+        //------------------------------------------------------------------------------
+        using Iterator = utilities::intern::GeneratorIterator<roundrobin>;
+        constexpr Iterator begin() { return Iterator{*this}; }
+        constexpr utilities::intern::GeneratorEnd end() { return {}; }
+
+    public:
+        //------------------------------------------------------------------------------
+        // operators - Emulating the generator class's operators
+        //------------------------------------------------------------------------------
+        constexpr typename State::Reference operator*() { return state_.current(); }
+        constexpr roundrobin& operator++() { state_.advance(); return *this; }
+        constexpr explicit operator bool() const { return state_.can_advance(); }
+    };
+
+    template<class... Iterables>
+    class interleave {
+    public:
+        //------------------------------------------------------------------------------
+        // Initialization variables - Can only be set via aggregate initialization
+        //------------------------------------------------------------------------------
+        using Storage = ZipStorage<0, Iterables...>;
+        Storage storage_;
+
+    public:
+        //------------------------------------------------------------------------------
+        // State of the generator - It's public to allow for aggregate initialization of
+        // the above variables, but this should be treated as private.
+        //------------------------------------------------------------------------------
+        using State = utilities::intern::RoundrobinStateOf<false, Iterables...>;
+        State state_{storage_};
+        UTILITIES_LOOP_PROBE
+
+    public:
+        //------------------------------------------------------------------------------
+        // Implicit Constructors - All Deleted
+        //------------------------------------------------------------------------------
+        constexpr interleave() = delete;
+        constexpr interleave(const interleave&) = delete;
+        constexpr interleave(interleave&&) = delete;
+        constexpr interleave& operator=(const interleave&) = delete;
+        constexpr interleave& operator=(interleave&&) = delete;
+
+    public:
+        //------------------------------------------------------------------------------
+        // Begin and End - Enables usage in ranged-for
+        //------------------------------------------------------------------------------
+        using Iterator = utilities::intern::GeneratorIterator<interleave>;
+        constexpr Iterator begin() { return Iterator{*this}; }
+        constexpr utilities::intern::GeneratorEnd end() { return {}; }
+
+    public:
+        //------------------------------------------------------------------------------
+        // operators - Emulating the generator class's operators
+        //------------------------------------------------------------------------------
+        constexpr typename State::Reference operator*() { return state_.current(); }
+        constexpr interleave& operator++() { state_.advance(); return *this; }
+        constexpr explicit operator bool() const { return state_.can_advance(); }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Deduction guides
+    //      roundrobin{some_iterable, more_iterables...}
+    //      interleave{some_iterable, more_iterables...}
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class RequiredIterable, class... OptionalIterables>
+    roundrobin(RequiredIterable&& required_iterable, OptionalIterables&&... optional_iterables)
+        -> roundrobin<decltype(required_iterable), decltype(optional_iterables)...>;
+
+    template<class RequiredIterable, class... OptionalIterables>
+    interleave(RequiredIterable&& required_iterable, OptionalIterables&&... optional_iterables)
+        -> interleave<decltype(required_iterable), decltype(optional_iterables)...>;
+}
@@ -0,0 +1,417 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "range.h"
+#include "simd.h"
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // gallop - Exponential search, the first position in [first, last) whose value
+    // isn't less than value. Costs O(log d) for an answer d positions ahead, which
+    // makes walking a long sorted range in large strides cheap.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class T>
+    const T* gallop(const T* first, const T* last, const T& value) {
+        if (first == last || !(*first < value)) { return first; }
+        const int64_t size = last - first;
+        int64_t low = 0, high = 1;
+        while (high < size && first[high] < value) { low = high; high *= 2; }
+        return std::lower_bound(first + low + 1, first + std::min(high, size), value);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Set operation cores - Each walks two sorted ranges of unique values and writes
+    // the next results to out with fill(out, capacity), returning how many it wrote,
+    // 0 once done. Balanced inputs are merged without branches, 32 bit integers (and
+    // 64 bit ones on targets with wide vectors) a block of lanes at a time: every
+    // value of a block of a is compared against a block of b at once, and the block
+    // with the smaller maximum advances. When one range is kSkew times longer than
+    // the other, the short one's values are galloped to in the long one instead.
+    ////////////////////////////////////////////////////////////////////////////////
+    constexpr int64_t kSkew = 64;
+
+    template<class T>
+    struct SortedRange {
+        const T* first;
+        const T* last;
+
+        int64_t size() const { return last - first; }
+    };
+
+    template<class T>
+    class IntersectionCore {
+    public:
+        using Value = T;
+
+        IntersectionCore(SortedRange<T> a, SortedRange<T> b)
+            : a_(a.size() <= b.size() ? a : b)
+            , b_(a.size() <= b.size() ? b : a)
+            , gallop_(b_.size() > kSkew * a_.size())
+        {
+            // Nothing
+        }
+
+        int64_t fill(T* out, int64_t capacity) {
+            int64_t count = 0;
+            if (gallop_) {
+                for (; count < capacity && a_.first != a_.last; ++a_.first) {
+                    b_.first = gallop(b_.first, b_.last, *a_.first);
+                    if (b_.first == b_.last) { a_.first = a_.last; break; }
+                    out[count] = *a_.first;
+                    count += !(*a_.first < *b_.first);
+                }
+                return count;
+            }
+
+#ifdef UTILITIES_HAS_VECTOR_EXTENSIONS
+            if constexpr (kHasIntegerBlocks<T>) {
+                constexpr int64_t kLanes = kBlockBytes / sizeof(T);
+                while (capacity - count >= kLanes && a_.size() >= kLanes && b_.size() >= kLanes) {
+                    Vector<T, kLanes> block;
+                    load(block, a_.first);
+                    auto found = block == b_.first[0];
+                    for (int64_t k = 1; k < kLanes; ++k) { found |= block == b_.first[k]; }
+                    for (int64_t lane = 0; lane < kLanes; ++lane) {
+                        out[count] = a_.first[lane];
+                        count += found[lane] != 0;
+                    }
+                    const T a_max = a_.first[kLanes - 1], b_max = b_.first[kLanes - 1];
+                    a_.first += kLanes * (a_max <= b_max);
+                    b_.first += kLanes * (b_max <= a_max);
+                }
+            }
+#endif
+
+            while (count < capacity && a_.first != a_.last && b_.first != b_.last) {
+                const T& a = *a_.first;
+                const T& b = *b_.first;
+                out[count] = a;
+                const bool a_less = a < b, b_less = b < a;
+                count += !a_less && !b_less;
+                a_.first += !b_less;
+                b_.first += !a_less;
+            }
+            return count;
+        }
+
+    private:
+        SortedRange<T> a_;
+        SortedRange<T> b_;
+        bool gallop_;
+    };
+
+    template<class T>
+    class UnionCore {
+    public:
+        using Value = T;
+
+        UnionCore(SortedRange<T> a, SortedRange<T> b)
+            : a_(a.size() <= b.size() ? a : b)
+            , b_(a.size() <= b.size() ? b : a)
+            , gallop_(b_.size() > kSkew * a_.size())
+        {
+            // Nothing
+        }
+
+        int64_t fill(T* out, int64_t capacity) {
+            int64_t count = 0;
+            if (gallop_) {
+                // Copies the runs of b between a's values
+                while (count < capacity && a_.first != a_.last) {
+                    const T* run_end = gallop(b_.first, b_.last, *a_.first);
+                    const int64_t run = std::min<int64_t>(run_end - b_.first, capacity - count);
+                    out = std::copy(b_.first, b_.first + run, out);
+                    b_.first += run;
+                    count += run;
+                    if (count == capacity) { break; }
+                    *out++ = *a_.first;
+                    ++count;
+                    b_.first += b_.first != b_.last && !(*a_.first < *b_.first);
+                    ++a_.first;
+                }
+            } else {
+                while (count < capacity && a_.first != a_.last && b_.first != b_.last) {
+                    const T& a = *a_.first;
+                    const T& b = *b_.first;
+                    const bool a_less = a < b, b_less = b < a;
+                    out[count++] = b_less ? b : a;
+                    a_.first += !b_less;
+                    b_.first += !a_less;
+                }
+                out += count;
+            }
+
+            for (SortedRange<T>* rest : {&a_, &b_}) {
+                const int64_t run = std::min(rest->size(), capacity - count);
+                out = std::copy(rest->first, rest->first + run, out);
+                rest->first += run;
+                count += run;
+            }
+            return count;
+        }
+
+    private:
+        SortedRange<T> a_;
+        SortedRange<T> b_;
+        bool gallop_;
+    };
+
+    template<class T>
+    class DifferenceCore {
+    public:
+        using Value = T;
+
+        DifferenceCore(SortedRange<T> a, SortedRange<T> b)
+            : a_(a)
+            , b_(b)
+            , gallop_a_(a.size() > kSkew * b.size())
+            , gallop_b_(b.size() > kSkew * a.size())
+        {
+            // Nothing
+        }
+
+        int64_t fill(T* out, int64_t capacity) {
+            int64_t count = 0;
+            if (gallop_b_) {
+                // Looks each value of a up in b
+                for (; count < capacity && a_.first != a_.last; ++a_.first) {
+                    b_.first = gallop(b_.first, b_.last, *a_.first);
+                    out[count] = *a_.first;
+                    count += b_.first == b_.last || *a_.first < *b_.first;
+                }
+                return count;
+            }
+
+            if (gallop_a_) {
+                // Copies the runs of a between b's values
+                while (count < capacity && b_.first != b_.last) {
+                    const T* run_end = gallop(a_.first, a_.last, *b_.first);
+                    const int64_t run = std::min<int64_t>(run_end - a_.first, capacity - count);
+                    std::copy(a_.first, a_.first + run, out + count);
+                    a_.first += run;
+                    count += run;
+                    if (count == capacity) { break; }
+                    a_.first += a_.first != a_.last && !(*b_.first < *a_.first);
+                    ++b_.first;
+                }
+            } else {
+#ifdef UTILITIES_HAS_VECTOR_EXTENSIONS
+                if constexpr (kHasIntegerBlocks<T>) {
+                    // A block of a is only written once every block of b that can
+                    // hold its values was compared against it. b restarts from the
+                    // pending block's first overlapping block of b if the loop ends.
+                    constexpr int64_t kLanes = kBlockBytes / sizeof(T);
+                    using Block = Vector<T, kLanes>;
+                    const T* pending_b = b_.first;
+                    decltype(std::declval<Block>() == std::declval<Block>()) found{};
+                    while (capacity - count >= kLanes && a_.size() >= kLanes && b_.size() >= kLanes) {
+                        Block block;
+                        load(block, a_.first);
+                        for (int64_t k = 0; k < kLanes; ++k) { found |= block == b_.first[k]; }
+                        const T a_max = a_.first[kLanes - 1], b_max = b_.first[kLanes - 1];
+                        if (a_max <= b_max) {
+                            for (int64_t lane = 0; lane < kLanes; ++lane) {
+                                out[count] = a_.first[lane];
+                                count += found[lane] == 0;
+                            }
+                            found = decltype(found){};
+                            a_.first += kLanes;
+                            b_.first += kLanes * (b_max == a_max);
+                            pending_b = b_.first;
+                        } else {
+                            b_.first += kLanes;
+                        }
+                    }
+                    b_.first = pending_b;
+                }
+#endif
+
+                while (count < capacity && a_.first != a_.last && b_.first != b_.last) {
+                    const T& a = *a_.first;
+                    const T& b = *b_.first;
+                    out[count] = a;
+                    const bool a_less = a < b, b_less = b < a;
+                    count += a_less;
+                    a_.first += !b_less;
+                    b_.first += !a_less;
+                }
+            }
+
+            if (b_.first == b_.last) {
+                const int64_t run = std::min(a_.size(), capacity - count);
+                std::copy(a_.first, a_.first + run, out + count);
+                a_.first += run;
+                count += run;
+            }
+            return count;
+        }
+
+    private:
+        SortedRange<T> a_;
+        SortedRange<T> b_;
+        bool gallop_a_;
+        bool gallop_b_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // KWayIntersectionCore - Intersects the two shortest ranges and then galloping
+    // filters each batch of candidates through the remaining ranges, shortest first.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class T>
+    class KWayIntersectionCore {
+    public:
+        using Value = T;
+
+        explicit KWayIntersectionCore(std::vector<SortedRange<T>> ranges)
+            : ranges_(by_size(std::move(ranges)))
+            , pair_(ranges_[0], ranges_[1])
+        {
+            // Nothing
+        }
+
+        int64_t fill(T* out, int64_t capacity) {
+            while (!exhausted_) {
+                int64_t count = pair_.fill(out, capacity);
+                exhausted_ = count == 0;
+                for (std::size_t i = 2; i < ranges_.size() && count > 0; ++i) {
+                    SortedRange<T>& range = ranges_[i];
+                    int64_t kept = 0;
+                    for (int64_t j = 0; j < count; ++j) {
+                        range.first = gallop(range.first, range.last, out[j]);
+                        if (range.first == range.last) { exhausted_ = true; break; }
+                        out[kept] = out[j];
+                        kept += !(out[j] < *range.first);
+                    }
+                    count = kept;
+                }
+                if (count > 0) { return count; }
+            }
+            return 0;
+        }
+
+    private:
+        static std::vector<SortedRange<T>> by_size(std::vector<SortedRange<T>> ranges) {
+            std::sort(ranges.begin(), ranges.end(), [](const SortedRange<T>& a, const SortedRange<T>& b) { return a.size() < b.size(); });
+            return ranges;
+        }
+
+        std::vector<SortedRange<T>> ranges_;
+        IntersectionCore<T> pair_;
+        bool exhausted_ = false;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // SetOperationImpl - The generator implementation shared by the set operations.
+    // The core's results are produced a buffer at a time and yielded from there.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Core>
+    class SetOperationImpl {
+    public:
+        using Value = typename Core::Value;
+        static constexpr int64_t kBuffer = 256;
+
+        //------------------------------------------------------------------------------
+        // Constructor - Must be initialized with a core, computes the first results
+        //------------------------------------------------------------------------------
+        SetOperationImpl(Core core)
+            : core_(std::move(core))
+        {
+            refill();
+        }
+
+    public:
+        //------------------------------------------------------------------------------
+        // operators - Provides the state, advances the generator, and determines completion
+        //------------------------------------------------------------------------------
+        const Value& operator*() { return buffer_[position_]; }
+        SetOperationImpl& operator++() { if (++position_ == filled_) { refill(); } return *this; }
+        explicit operator bool() const { return position_ < filled_; }
+
+    private:
+        void refill() {
+            position_ = 0;
+            filled_ = core_.fill(buffer_.data(), kBuffer);
+        }
+
+        //------------------------------------------------------------------------------
+        // Member Variables
+        //------------------------------------------------------------------------------
+        Core core_;
+        std::array<Value, kBuffer> buffer_;
+        int64_t position_ = 0;
+        int64_t filled_ = 0;
+    };
+
+    template<class Container>
+    using SortedValue = std::remove_cv_t<std::remove_pointer_t<decltype(std::data(std::declval<Container&>()))>>;
+
+    template<class Container>
+    SortedRange<SortedValue<Container>> sorted_range(const Container& container) {
+        return {std::data(container), std::data(container) + std::size(container)};
+    }
+}
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // Define the set operation generators
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class T>
+    using Intersection = utilities::intern::Generator<utilities::intern::SetOperationImpl<utilities::intern::IntersectionCore<T>>>;
+
+    template<class T>
+    using Union = utilities::intern::Generator<utilities::intern::SetOperationImpl<utilities::intern::UnionCore<T>>>;
+
+    template<class T>
+    using Difference = utilities::intern::Generator<utilities::intern::SetOperationImpl<utilities::intern::DifferenceCore<T>>>;
+
+    template<class T>
+    using KWayIntersection = utilities::intern::Generator<utilities::intern::SetOperationImpl<utilities::intern::KWayIntersectionCore<T>>>;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Set operations on sorted ranges - Generators over the ascending values of
+    // sorted, duplicate free containers in contiguous storage, e.g. posting lists.
+    // The containers are referred to, not copied, so they can't be temporaries.
+    //      intersect(a, b) - the values in both a and b
+    //      unite(a, b) - the values in a or b (union is a keyword)
+    //      difference(a, b) - the values in a but not b
+    //      intersect_all(lists) - the values in every one of a container of at least
+    //                             two containers
+    //          for (auto [i, id] : enumerate{ intersect(with_term, with_other_term) }) { }
+    // Integers are compared a vector at a time and ranges of very different lengths
+    // are combined by galloping through the longer one; see the cores above.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class A, class B, class = std::enable_if_t<!std::is_rvalue_reference_v<A&&> && !std::is_rvalue_reference_v<B&&>>>
+    Intersection<utilities::intern::SortedValue<A>> intersect(A&& a, B&& b UTILITIES_LOOP_SITE_PARAMS) {
+        static_assert(std::is_same_v<utilities::intern::SortedValue<A>, utilities::intern::SortedValue<B>>, "intersect needs ranges of the same type");
+        return {{{utilities::intern::sorted_range(a), utilities::intern::sorted_range(b)}} UTILITIES_LOOP_SITE_ARGS};
+    }
+
+    template<class A, class B, class = std::enable_if_t<!std::is_rvalue_reference_v<A&&> && !std::is_rvalue_reference_v<B&&>>>
+    Union<utilities::intern::SortedValue<A>> unite(A&& a, B&& b UTILITIES_LOOP_SITE_PARAMS) {
+        static_assert(std::is_same_v<utilities::intern::SortedValue<A>, utilities::intern::SortedValue<B>>, "unite needs ranges of the same type");
+        return {{{utilities::intern::sorted_range(a), utilities::intern::sorted_range(b)}} UTILITIES_LOOP_SITE_ARGS};
+    }
+
+    template<class A, class B, class = std::enable_if_t<!std::is_rvalue_reference_v<A&&> && !std::is_rvalue_reference_v<B&&>>>
+    Difference<utilities::intern::SortedValue<A>> difference(A&& a, B&& b UTILITIES_LOOP_SITE_PARAMS) {
+        static_assert(std::is_same_v<utilities::intern::SortedValue<A>, utilities::intern::SortedValue<B>>, "difference needs ranges of the same type");
+        return {{{utilities::intern::sorted_range(a), utilities::intern::sorted_range(b)}} UTILITIES_LOOP_SITE_ARGS};
+    }
+
+    template<class Lists, class = std::enable_if_t<!std::is_rvalue_reference_v<Lists&&>>>
+    auto intersect_all(Lists&& lists UTILITIES_LOOP_SITE_PARAMS)
+        -> KWayIntersection<utilities::intern::SortedValue<decltype(*std::begin(lists))>> {
+        using T = utilities::intern::SortedValue<decltype(*std::begin(lists))>;
+        std::vector<utilities::intern::SortedRange<T>> ranges;
+        for (const auto& list : lists) { ranges.push_back(utilities::intern::sorted_range(list)); }
+        if (ranges.size() < 2) { throw std::invalid_argument("intersect_all needs at least two lists"); }
+        return {{utilities::intern::KWayIntersectionCore<T>{std::move(ranges)}} UTILITIES_LOOP_SITE_ARGS};
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+////////////////////////////////////////////////////////////////////////////////
+// SIMD helpers - Portable vector types through the gcc/clang vector extensions.
+// They compile to whatever the target offers (SSE2, AVX2, AVX-512, NEON) and are
+// split into smaller registers when a width isn't available. Code using them must
+// provide a scalar fallback for when UTILITIES_HAS_VECTOR_EXTENSIONS isn't defined.
+//
+// Vectors are kept inside the functions that use them, passing them by value
+// across non inlined calls would depend on the target's ABI.
+//
+// UTILITIES_HAS_WIDE_VECTORS is defined for targets with fast 64 bit lane
+// operations (AVX2 and up, AArch64). On baseline x86-64 the 64 bit lane code paths
+// are usually slower than scalar code and should be skipped.
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__GNUC__) || defined(__clang__)
+#define UTILITIES_HAS_VECTOR_EXTENSIONS 1
+
+#if defined(__AVX2__) || defined(__aarch64__)
+#define UTILITIES_HAS_WIDE_VECTORS 1
+#endif
+
+namespace utilities::intern {
+    template<class T, std::size_t Lanes>
+    struct VectorType {
+        typedef T type __attribute__((vector_size(Lanes * sizeof(T))));
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Vector - Lanes values of T, supporting the built in arithmetic, bitwise and
+    // comparison operators element wise. Comparisons yield lanes of all ones or zero.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class T, std::size_t Lanes>
+    using Vector = typename VectorType<T, Lanes>::type;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // load/store - Unaligned memory access for vectors. load writes to a reference,
+    // returning a vector wider than the target's registers triggers gcc's ABI warning.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class VectorT, class T>
+    __attribute__((always_inline)) inline void load(VectorT& destination, const T* source) {
+        std::memcpy(&destination, source, sizeof(destination));
+    }
+
+    template<class VectorT, class T>
+    __attribute__((always_inline)) inline void store(T* destination, const VectorT& value) {
+        std::memcpy(destination, &value, sizeof(value));
+    }
+}
+
+#endif
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // kBlockBytes - The vector width used to process blocks of values
+    // kHasIntegerBlocks - Whether comparing blocks of integers of type T beats
+    // comparing them one at a time on this target
+    ////////////////////////////////////////////////////////////////////////////////
+#ifdef UTILITIES_HAS_WIDE_VECTORS
+    constexpr std::size_t kBlockBytes = 32;
+#else
+    constexpr std::size_t kBlockBytes = 16;
+#endif
+
+#ifdef UTILITIES_HAS_VECTOR_EXTENSIONS
+    template<class T>
+    constexpr bool kHasIntegerBlocks = std::is_integral_v<T> && (sizeof(T) == 4
+#ifdef UTILITIES_HAS_WIDE_VECTORS
+                                                                 || sizeof(T) == 8
+#endif
+                                                                 );
+#else
+    template<class T>
+    constexpr bool kHasIntegerBlocks = false;
+#endif
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include "range.h"
+#include "enumerate.h"
+#include "zip.h"
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // size_hint - The number of elements an iterable will produce, if that can be
+    // known without iterating it. Containers, arrays and range report their size,
+    // enumerate reports the size of what it wraps and zip reports the shortest of
+    // its iterables. Anything else has no hint.
+    //
+    // All overloads are declared up front so that nested generators, e.g. an
+    // enumerate of a zip, find each other.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable>
+    constexpr std::optional<int64_t> size_hint(Iterable& iterable);
+
+    template<class Iterable>
+    constexpr std::optional<int64_t> size_hint(enumerate<Iterable>& enumerated);
+
+    template<size_t IDX, class CurrentIterable, class... RemainingIterables>
+    constexpr std::optional<int64_t> size_hint(ZipStorage<IDX, CurrentIterable, RemainingIterables...>& storage);
+
+    template<class... Iterables>
+    constexpr std::optional<int64_t> size_hint(zip<Iterables...>& zipped);
+
+    template<class Iterable>
+    constexpr std::optional<int64_t> size_hint(Iterable& iterable) {
+        if constexpr (HasSize<Iterable>::value) {
+            return static_cast<int64_t>(std::size(iterable));
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    template<class Iterable>
+    constexpr std::optional<int64_t> size_hint(enumerate<Iterable>& enumerated) {
+        return size_hint(enumerated.iterable_);
+    }
+
+    template<size_t IDX, class CurrentIterable, class... RemainingIterables>
+    constexpr std::optional<int64_t> size_hint(ZipStorage<IDX, CurrentIterable, RemainingIterables...>& storage) {
+        std::optional<int64_t> current = size_hint(storage.iterable);
+        if constexpr (sizeof...(RemainingIterables) == 0) {
+            return current;
+        } else {
+            std::optional<int64_t> remaining = size_hint(storage.next_storage);
+            if (!current || !remaining) { return std::nullopt; }
+            return std::min(*current, *remaining);
+        }
+    }
+
+    template<class... Iterables>
+    constexpr std::optional<int64_t> size_hint(zip<Iterables...>& zipped) {
+        return size_hint(zipped.storage_);
+    }
+}
@@ -0,0 +1,713 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "parallel.h"
+#include "random.h"
+#include "zip.h"
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // RadixKey - Maps a key to an unsigned integer of the same size whose order is the
+    // key's order. Signed integers get their sign bit flipped. IEEE floats get all
+    // bits flipped when negative and the sign bit flipped otherwise, which orders
+    // -inf < negatives < 0 < positives < +inf, with NaNs at the ends. -0 is encoded
+    // as +0 since the two compare equal, so sorting keeps their order.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<std::size_t Size> struct UnsignedOfSize;
+    template<> struct UnsignedOfSize<1> { using type = uint8_t; };
+    template<> struct UnsignedOfSize<2> { using type = uint16_t; };
+    template<> struct UnsignedOfSize<4> { using type = uint32_t; };
+    template<> struct UnsignedOfSize<8> { using type = uint64_t; };
+
+    template<class Key>
+    struct RadixKey {
+        static_assert((std::is_integral_v<Key> && !std::is_same_v<Key, bool>) || std::is_floating_point_v<Key>,
+                      "radix_sort: keys must be integers or floating point numbers");
+        using Bits = typename UnsignedOfSize<sizeof(Key)>::type;
+        static constexpr int kBytes = sizeof(Key);
+        static constexpr Bits kSignBit = Bits{1} << (8 * sizeof(Key) - 1);
+
+        static Bits encode(Key key) {
+            if constexpr (std::is_floating_point_v<Key>) {
+                if (key == Key(0)) { key = Key(0); }
+            }
+            Bits bits;
+            std::memcpy(&bits, &key, sizeof(bits));
+            if constexpr (std::is_floating_point_v<Key>) {
+                return (bits & kSignBit) ? static_cast<Bits>(~bits) : static_cast<Bits>(bits | kSignBit);
+            } else if constexpr (std::is_signed_v<Key>) {
+                return static_cast<Bits>(bits ^ kSignBit);
+            } else {
+                return bits;
+            }
+        }
+
+        static unsigned digit(Key key, int byte) { return static_cast<unsigned>(encode(key) >> (8 * byte)) & 0xFF; }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // RadixSorter - Stable MSD radix sort of a key column and any number of payload
+    // columns moved along with it, one byte per level starting at the highest byte
+    // in which the keys differ.
+    //
+    // Every level counts the bucket sizes and scatters the rows into a buffer of
+    // the same shape, so the data alternates between the columns and the buffer;
+    // bytes all keys share are skipped without moving anything. Buckets below
+    // kInsertionBelow rows are finished with an insertion sort. Columns are scattered
+    // one after another through a software write combining buffer per bucket, which
+    // turns scattered single writes into full cache line writes.
+    //
+    // Large inputs are split across threads: each thread counts and scatters its
+    // own chunk at offsets computed from all threads' counts, then the buckets are
+    // sorted as independent tasks.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Key, class... Payloads>
+    class RadixSorter {
+    public:
+        static constexpr int64_t kInsertionBelow = 64;
+        static constexpr int64_t kParallelAbove = int64_t{1} << 20;
+        static constexpr int64_t kWriteCombineAbove = 4096;
+
+        using Columns = std::tuple<Key*, Payloads*...>;
+        using Counts = std::array<int64_t, 256>;
+
+        RadixSorter(int64_t count, Key* keys, Payloads*... payloads)
+            : count_(count)
+            , columns_(keys, payloads...)
+            , buffers_(std::vector<Key>(count), std::vector<Payloads>(count)...)
+            , buffer_columns_(std::apply([](auto&... buffers) { return Columns{buffers.data()...}; }, buffers_))
+        {
+            // Nothing
+        }
+
+        void sort(int64_t threads = hardware_threads()) {
+            if (count_ < kParallelAbove) { threads = 1; }
+            const int byte = highest_differing_byte(threads);
+            if (byte < 0) { return; }
+            if (threads > 1) {
+                sort_parallel(byte, threads);
+            } else {
+                sort_range(0, count_, byte, false);
+            }
+        }
+
+    private:
+        using Radix = RadixKey<Key>;
+
+        const Columns& source(bool in_buffer) const { return in_buffer ? buffer_columns_ : columns_; }
+
+        int highest_differing_byte(int64_t threads) const {
+            const Key* keys = std::get<0>(columns_);
+            if (count_ < 2) { return -1; }
+            const auto first = Radix::encode(keys[0]);
+            std::vector<typename Radix::Bits> chunk_differing(threads);
+            parallel_tasks(threads, [&](int64_t chunk) {
+                typename Radix::Bits differing = 0;
+                for (int64_t i = count_ * chunk / threads; i < count_ * (chunk + 1) / threads; ++i) {
+                    differing |= Radix::encode(keys[i]) ^ first;
+                }
+                chunk_differing[chunk] = differing;
+            }, threads);
+
+            typename Radix::Bits differing = 0;
+            for (auto chunk : chunk_differing) { differing |= chunk; }
+            int byte = -1;
+            for (; differing != 0; differing >>= 8) { ++byte; }
+            return byte;
+        }
+
+        // Sorts the rows [first, first + count) that are currently in the columns or
+        // the buffer, leaving them sorted in the columns
+        void sort_range(int64_t first, int64_t count, int byte, bool in_buffer) {
+            for (;;) {
+                if (count < kInsertionBelow || byte < 0) {
+                    if (in_buffer) { copy_rows(buffer_columns_, columns_, first, count); }
+                    if (byte >= 0) { insertion_sort(first, count); }
+                    return;
+                }
+
+                Counts counts{};
+                const Key* keys = std::get<0>(source(in_buffer)) + first;
+                for (int64_t i = 0; i < count; ++i) { ++counts[Radix::digit(keys[i], byte)]; }
+                if (*std::max_element(counts.begin(), counts.end()) == count) {
+                    --byte;  // Every key has the same digit here
+                    continue;
+                }
+
+                Counts offsets;
+                int64_t offset = first;
+                for (int digit = 0; digit < 256; ++digit) { offsets[digit] = offset; offset += counts[digit]; }
+                scatter(source(in_buffer), source(!in_buffer), first, count, byte, offsets);
+
+                offset = first;
+                for (int digit = 0; digit < 256; ++digit) {
+                    if (counts[digit] > 0) { sort_range(offset, counts[digit], byte - 1, !in_buffer); }
+                    offset += counts[digit];
+                }
+                return;
+            }
+        }
+
+        void sort_parallel(int byte, int64_t threads) {
+            auto bound = [&](int64_t chunk) { return count_ * chunk / threads; };
+            std::vector<Counts> counts(threads);
+            parallel_tasks(threads, [&](int64_t chunk) {
+                Counts& chunk_counts = counts[chunk];
+                chunk_counts.fill(0);
+                const Key* keys = std::get<0>(columns_);
+                for (int64_t i = bound(chunk); i < bound(chunk + 1); ++i) { ++chunk_counts[Radix::digit(keys[i], byte)]; }
+            }, threads);
+
+            // Bucket by bucket, each chunk's rows follow those of the chunks before it
+            std::vector<Counts> offsets(threads);
+            Counts bucket_begin{}, bucket_size{};
+            int64_t offset = 0;
+            for (int digit = 0; digit < 256; ++digit) {
+                bucket_begin[digit] = offset;
+                for (int64_t chunk = 0; chunk < threads; ++chunk) {
+                    offsets[chunk][digit] = offset;
+                    offset += counts[chunk][digit];
+                }
+                bucket_size[digit] = offset - bucket_begin[digit];
+            }
+
+            parallel_tasks(threads, [&](int64_t chunk) {
+                scatter(columns_, buffer_columns_, bound(chunk), bound(chunk + 1) - bound(chunk), byte, offsets[chunk]);
+            }, threads);
+
+            // The largest buckets first, so that they don't end up running last
+            std::vector<int> order;
+            for (int digit = 0; digit < 256; ++digit) { if (bucket_size[digit] > 0) { order.push_back(digit); } }
+            std::sort(order.begin(), order.end(), [&](int a, int b) { return bucket_size[a] > bucket_size[b]; });
+            parallel_tasks(static_cast<int64_t>(order.size()), [&](int64_t task) {
+                const int digit = order[task];
+                sort_range(bucket_begin[digit], bucket_size[digit], byte - 1, true);
+            }, threads);
+        }
+
+        // Moves the rows [first, first + count) of from to the positions given by the
+        // key's digit, offsets holds each bucket's next position and is advanced
+        void scatter(const Columns& from, const Columns& to, int64_t first, int64_t count, int byte, Counts& offsets) {
+            const Key* keys = std::get<0>(from) + first;
+            Counts column_offsets;
+            std::apply([&](auto*... from_columns) {
+                std::apply([&](auto*... to_columns) {
+                    (..., (column_offsets = offsets, scatter_column(keys, from_columns + first, to_columns, count, byte, column_offsets)));
+                }, to);
+            }, from);
+            offsets = column_offsets;
+        }
+
+        template<class T>
+        static void scatter_column(const Key* keys, const T* from, T* to, int64_t count, int byte, Counts& offsets) {
+            if constexpr (std::is_trivially_copyable_v<T> && sizeof(T) <= 32) {
+                if (count < kWriteCombineAbove) {
+                    for (int64_t i = 0; i < count; ++i) { to[offsets[Radix::digit(keys[i], byte)]++] = from[i]; }
+                    return;
+                }
+                // Write combining: rows gather per bucket and leave a cache line at a time.
+                // Only the rows are copied, a line can hold fewer than 64 bytes of them.
+                constexpr int kRows = 64 / sizeof(T);
+                struct alignas(64) Line { T rows[kRows]; };
+                std::vector<Line> lines(256);
+                uint8_t filled[256] = {};
+                for (int64_t i = 0; i < count; ++i) {
+                    const unsigned digit = Radix::digit(keys[i], byte);
+                    lines[digit].rows[filled[digit]++] = from[i];
+                    if (filled[digit] == kRows) {
+                        std::memcpy(to + offsets[digit], lines[digit].rows, kRows * sizeof(T));
+                        offsets[digit] += kRows;
+                        filled[digit] = 0;
+                    }
+                }
+                for (int digit = 0; digit < 256; ++digit) {
+                    std::memcpy(to + offsets[digit], lines[digit].rows, filled[digit] * sizeof(T));
+                    offsets[digit] += filled[digit];
+                }
+            } else {
+                for (int64_t i = 0; i < count; ++i) { to[offsets[Radix::digit(keys[i], byte)]++] = std::move(from[i]); }
+            }
+        }
+
+        static void copy_rows(const Columns& from, const Columns& to, int64_t first, int64_t count) {
+            std::apply([&](auto*... from_columns) {
+                std::apply([&](auto*... to_columns) {
+                    (..., std::move(from_columns + first, from_columns + first + count, to_columns + first));
+                }, to);
+            }, from);
+        }
+
+        // Stable insertion sort of the rows [first, first + count) in the columns
+        void insertion_sort(int64_t first, int64_t count) {
+            Key* keys = std::get<0>(columns_) + first;
+            for (int64_t i = 1; i < count; ++i) {
+                const auto bits = Radix::encode(keys[i]);
+                int64_t j = i;
+                while (j > 0 && bits < Radix::encode(keys[j - 1])) { --j; }
+                if (j == i) { continue; }
+                std::apply([&](auto*... columns) {
+                    (..., std::rotate(columns + first + j, columns + first + i, columns + first + i + 1));
+                }, columns_);
+            }
+        }
+
+        const int64_t count_;
+        const Columns columns_;
+        std::tuple<std::vector<Key>, std::vector<Payloads>...> buffers_;
+        const Columns buffer_columns_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // sample_sort - Parallel sample sort of contiguous values with any comparator.
+    // Sorted samples pick splitters that divide the values into a few buckets per
+    // thread. Each thread classifies its chunk by binary search over the splitters
+    // and moves it into a buffer at offsets computed from all threads' counts, then
+    // the buckets are sorted as independent tasks and moved back.
+    // Values equal to a splitter get a bucket of their own that needs no sorting,
+    // so duplicates can't pile up in one bucket. Chunks keep their order when
+    // scattered, so with Stable the result is a stable sort.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<bool Stable, class T, class Compare>
+    void sample_sort(T* values, int64_t count, Compare comp, int64_t threads) {
+        constexpr int64_t kParallelAbove = int64_t{1} << 16;
+        constexpr int64_t kOversampling = 16;
+        auto local_sort = [&comp](T* first, T* last) {
+            if constexpr (Stable) { std::stable_sort(first, last, comp); } else { std::sort(first, last, comp); }
+        };
+        if (threads <= 1 || count < kParallelAbove) {
+            local_sort(values, values + count);
+            return;
+        }
+
+        const int64_t splitter_count = std::min<int64_t>(4 * threads, 1024) - 1;
+        std::vector<T> splitters;
+        {
+            std::vector<T> samples;
+            uint64_t state = static_cast<uint64_t>(count);
+            for (int64_t i = 0; i < (splitter_count + 1) * kOversampling; ++i) {
+                samples.push_back(values[splitmix64(state) % static_cast<uint64_t>(count)]);
+            }
+            std::sort(samples.begin(), samples.end(), comp);
+            for (int64_t i = 1; i <= splitter_count; ++i) { splitters.push_back(samples[i * kOversampling]); }
+        }
+
+        // Bucket 2j holds the values between splitter j - 1 and j, bucket 2j + 1 those equal to splitter j
+        const int64_t bucket_count = 2 * splitter_count + 1;
+        auto classify = [&](const T& value) -> int64_t {
+            const int64_t above = std::upper_bound(splitters.begin(), splitters.end(), value, comp) - splitters.begin();
+            return (above > 0 && !comp(splitters[above - 1], value)) ? 2 * above - 1 : 2 * above;
+        };
+
+        auto bound = [&](int64_t chunk) { return count * chunk / threads; };
+        std::vector<uint16_t> buckets(count);
+        std::vector<std::vector<int64_t>> offsets(threads, std::vector<int64_t>(bucket_count));
+        parallel_tasks(threads, [&](int64_t chunk) {
+            for (int64_t i = bound(chunk); i < bound(chunk + 1); ++i) {
+                buckets[i] = static_cast<uint16_t>(classify(values[i]));
+                ++offsets[chunk][buckets[i]];
+            }
+        }, threads);
+
+        std::vector<int64_t> bucket_begin(bucket_count + 1);
+        int64_t offset = 0;
+        for (int64_t bucket = 0; bucket < bucket_count; ++bucket) {
+            bucket_begin[bucket] = offset;
+            for (int64_t chunk = 0; chunk < threads; ++chunk) {
+                const int64_t chunk_count = offsets[chunk][bucket];
+                offsets[chunk][bucket] = offset;
+                offset += chunk_count;
+            }
+        }
+        bucket_begin[bucket_count] = offset;
+
+        std::vector<T> buffer(count);
+        parallel_tasks(threads, [&](int64_t chunk) {
+            for (int64_t i = bound(chunk); i < bound(chunk + 1); ++i) { buffer[offsets[chunk][buckets[i]]++] = std::move(values[i]); }
+        }, threads);
+
+        parallel_tasks(bucket_count, [&](int64_t bucket) {
+            T* first = buffer.data() + bucket_begin[bucket];
+            T* last = buffer.data() + bucket_begin[bucket + 1];
+            if (bucket % 2 == 0) { local_sort(first, last); }
+            std::move(first, last, values + bucket_begin[bucket]);
+        }, threads);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // assign_columns - Writes the elements of tuple rows back into the columns they
+    // were taken from, column by column
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Columns, class Rows, std::size_t... Is>
+    void assign_columns(Columns columns, Rows& rows, std::index_sequence<Is...>) {
+        (..., [&] {
+            auto it = std::begin(std::get<Is>(columns));
+            for (auto& row : rows) {
+                *it = std::move(std::get<Is>(row));
+                ++it;
+            }
+        }());
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // KeyedRow - A row's key, computed once, and its position. Ordering rows by key
+    // and then position makes any sort stable.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Key>
+    struct KeyedRow {
+        Key key;
+        int64_t index;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // StringSorter - Stable multikey quicksort of strings, 8 bytes at a time. Each row
+    // caches the current 8 byte chunk of its string as a big endian integer, so the
+    // partitioning compares integers and doesn't touch the strings. Rows whose
+    // chunks tie move on to the next chunk; those whose strings end within the
+    // chunk are done and only ordered by length. Small groups are finished with an
+    // insertion sort on the remaining bytes. Ties are broken by index.
+    ////////////////////////////////////////////////////////////////////////////////
+    class StringSorter {
+    public:
+        static constexpr int64_t kInsertionBelow = 32;
+
+        // The indices that stably sort keys
+        static std::vector<int64_t> order(const std::vector<std::string_view>& keys) {
+            const int64_t count = static_cast<int64_t>(keys.size());
+            std::vector<Row> rows(count);
+            for (int64_t i = 0; i < count; ++i) { rows[i] = Row{chunk(keys[i], 0), keys[i], i}; }
+            sort(rows.data(), count, 0);
+
+            std::vector<int64_t> result(count);
+            for (int64_t i = 0; i < count; ++i) { result[i] = rows[i].index; }
+            return result;
+        }
+
+    private:
+        struct Row {
+            uint64_t chunk;
+            std::string_view key;
+            int64_t index;
+        };
+
+        // Bytes [8 * depth, 8 * depth + 8) of key as a big endian integer, zero padded
+        static uint64_t chunk(std::string_view key, std::size_t depth) {
+            const std::size_t first = 8 * depth;
+            if (first >= key.size()) { return 0; }
+            unsigned char bytes[8] = {};
+            std::memcpy(bytes, key.data() + first, std::min<std::size_t>(8, key.size() - first));
+            uint64_t result = 0;
+            for (unsigned char byte : bytes) { result = result << 8 | byte; }
+            return result;
+        }
+
+        static bool ends_within(const Row& row, std::size_t depth) { return row.key.size() <= 8 * (depth + 1); }
+
+        // Rows reaching depth share their first 8 * depth bytes
+        static bool less_from(const Row& a, const Row& b, std::size_t depth) {
+            const std::size_t first = std::min({8 * depth, a.key.size(), b.key.size()});
+            const int order = a.key.substr(first).compare(b.key.substr(first));
+            return order < 0 || (order == 0 && a.index < b.index);
+        }
+
+        static void sort(Row* rows, int64_t count, std::size_t depth) {
+            for (;;) {
+                if (count < kInsertionBelow) {
+                    for (int64_t i = 1; i < count; ++i) {
+                        Row row = rows[i];
+                        int64_t j = i;
+                        for (; j > 0 && less_from(row, rows[j - 1], depth); --j) { rows[j] = rows[j - 1]; }
+                        rows[j] = row;
+                    }
+                    return;
+                }
+
+                const uint64_t a = rows[0].chunk, b = rows[count / 2].chunk, c = rows[count - 1].chunk;
+                const uint64_t pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+                int64_t less = 0, i = 0, greater = count;
+                while (i < greater) {
+                    if (rows[i].chunk < pivot) {
+                        std::swap(rows[less++], rows[i++]);
+                    } else if (pivot < rows[i].chunk) {
+                        std::swap(rows[i], rows[--greater]);
+                    } else {
+                        ++i;
+                    }
+                }
+                sort(rows, less, depth);
+                sort(rows + greater, count - greater, depth);
+
+                // The rows with the pivot chunk: finished strings first, by length, then the rest by the next chunk
+                Row* equal = rows + less;
+                Row* unfinished = std::partition(equal, rows + greater, [depth](const Row& row) { return ends_within(row, depth); });
+                std::sort(equal, unfinished, [](const Row& x, const Row& y) {
+                    return x.key.size() < y.key.size() || (x.key.size() == y.key.size() && x.index < y.index);
+                });
+                ++depth;
+                for (Row* row = unfinished; row != rows + greater; ++row) { row->chunk = chunk(row->key, depth); }
+                count = (rows + greater) - unfinished;
+                rows = unfinished;
+            }
+        }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // stable_order - The indices that stably sort keys, ascending or descending.
+    // Integer and floating point keys are radix sorted together with their indices,
+    // strings go through the StringSorter, anything else is sorted as packed
+    // (key, index) rows by the sample sort.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Key>
+    constexpr bool kIsRadixKey = ((std::is_integral_v<Key> && !std::is_same_v<Key, bool>) || std::is_floating_point_v<Key>)
+                                 && (sizeof(Key) == 1 || sizeof(Key) == 2 || sizeof(Key) == 4 || sizeof(Key) == 8);
+
+    template<class Key>
+    constexpr bool kIsStringKey = std::is_same_v<Key, std::string> || std::is_same_v<Key, std::string_view>;
+
+    // Turns an ascending stable order into a descending stable one, same(i, j) tells
+    // whether the keys at positions i and j of the ascending order are equal
+    template<class Same>
+    void reverse_stable(std::vector<int64_t>& order, Same same) {
+        std::vector<int64_t> reversed;
+        reversed.reserve(order.size());
+        for (int64_t last = static_cast<int64_t>(order.size()); last > 0;) {
+            int64_t first = last - 1;
+            while (first > 0 && same(first - 1, first)) { --first; }
+            reversed.insert(reversed.end(), order.begin() + first, order.begin() + last);
+            last = first;
+        }
+        order.swap(reversed);
+    }
+
+    template<class Key>
+    std::vector<int64_t> stable_order(std::vector<Key> keys, bool reverse, int64_t threads = hardware_threads()) {
+        const int64_t count = static_cast<int64_t>(keys.size());
+        std::vector<int64_t> order(count);
+        if constexpr (kIsRadixKey<Key>) {
+            for (int64_t i = 0; i < count; ++i) { order[i] = i; }
+            RadixSorter<Key, int64_t>(count, keys.data(), order.data()).sort(threads);
+            if (reverse) {
+                reverse_stable(order, [&keys](int64_t i, int64_t j) { return RadixKey<Key>::encode(keys[i]) == RadixKey<Key>::encode(keys[j]); });
+            }
+        } else if constexpr (kIsStringKey<Key>) {
+            const std::vector<std::string_view> views(keys.begin(), keys.end());
+            order = StringSorter::order(views);
+            if (reverse) {
+                reverse_stable(order, [&](int64_t i, int64_t j) { return views[order[i]] == views[order[j]]; });
+            }
+        } else {
+            using Row = KeyedRow<Key>;
+            std::vector<Row> rows;
+            rows.reserve(count);
+            for (int64_t i = 0; i < count; ++i) { rows.push_back(Row{std::move(keys[i]), i}); }
+            auto comp = [reverse](const Row& a, const Row& b) {
+                if (a.key < b.key) { return !reverse; }
+                if (b.key < a.key) { return reverse; }
+                return a.index < b.index;
+            };
+            sample_sort<false>(rows.data(), count, comp, threads);
+            for (int64_t i = 0; i < count; ++i) { order[i] = rows[i].index; }
+        }
+        return order;
+    }
+
+    // The order of a string column, for sorting it in place
+    template<class Column>
+    std::vector<int64_t> string_column_order(const Column& column, int64_t count) {
+        const std::vector<std::string_view> views(std::begin(column), std::begin(column) + count);
+        return StringSorter::order(views);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // row_of - What key functions are called with: enumerate and zip states as
+    // materialized std::tuples, anything else as it is
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Value>
+    decltype(auto) row_of(Value&& value) {
+        if constexpr (HasMemberGet<std::decay_t<Value>>::value) {
+            return materialize(value);
+        } else {
+            return std::forward<Value>(value);
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // permute_columns - Rearranges every column so that row i becomes the old row
+    // order[i]. Rows are gathered in blocks of kBlock indices, each block of order is
+    // read once for all columns while it's in cache, and blocks run in parallel.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class... Columns>
+    void permute_columns(const std::vector<int64_t>& order, Columns&... columns) {
+        constexpr int64_t kBlock = 4096;
+        const int64_t count = static_cast<int64_t>(order.size());
+        if (((static_cast<int64_t>(std::size(columns)) < count) || ...)) {
+            throw std::invalid_argument("permute: order has more rows than a column");
+        }
+
+        std::tuple<std::vector<std::decay_t<decltype(*std::begin(columns))>>...> gathered{
+            std::vector<std::decay_t<decltype(*std::begin(columns))>>(count)...};
+        const int64_t blocks = (count + kBlock - 1) / kBlock;
+        const int64_t threads = count >= 16 * kBlock ? hardware_threads() : 1;
+        parallel_tasks(blocks, [&](int64_t block) {
+            const int64_t first = block * kBlock, last = std::min(first + kBlock, count);
+            std::apply([&](auto&... targets) {
+                (..., [&](auto& target, auto& column) {
+                    const auto source = std::begin(column);
+                    for (int64_t i = first; i < last; ++i) { target[i] = std::move(source[order[i]]); }
+                }(targets, columns));
+            }, gathered);
+        }, threads);
+        std::apply([&](auto&... targets) {
+            (..., std::move(targets.begin(), targets.end(), std::begin(columns)));
+        }, gathered);
+    }
+}
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // radix_sort - Stable radix sort of integer or floating point keys in contiguous
+    // storage. Given a zip, the first iterable holds the keys and the others are
+    // payload columns that are rearranged along with them; only as many rows as the
+    // shortest iterable has are sorted.
+    //      radix_sort(ids);
+    //      radix_sort(zip{ timestamps, values, names });
+    // Needs a buffer the size of the data. Large inputs are sorted on all cores.
+    // std::string and std::string_view keys are sorted by a multikey quicksort over
+    // cached 8 byte chunks instead, and the columns permuted afterwards.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Keys, class = std::enable_if_t<!std::is_rvalue_reference_v<Keys&&>>>
+    void radix_sort(Keys&& keys, int64_t threads = utilities::intern::hardware_threads()) {
+        using Key = std::remove_const_t<std::remove_pointer_t<decltype(std::data(keys))>>;
+        const auto count = static_cast<int64_t>(std::size(keys));
+        if constexpr (utilities::intern::kIsStringKey<Key>) {
+            utilities::intern::permute_columns(utilities::intern::string_column_order(keys, count), keys);
+        } else {
+            utilities::intern::RadixSorter<Key> sorter(count, std::data(keys));
+            sorter.sort(threads);
+        }
+    }
+
+    template<class... Iterables>
+    void radix_sort(zip<Iterables...>&& zipped, int64_t threads = utilities::intern::hardware_threads()) {
+        std::apply([threads](auto& keys, auto&... payloads) {
+            using Key = std::remove_const_t<std::remove_pointer_t<decltype(std::data(keys))>>;
+            const int64_t count = std::min({static_cast<int64_t>(std::size(keys)), static_cast<int64_t>(std::size(payloads))...});
+            if constexpr (utilities::intern::kIsStringKey<Key>) {
+                utilities::intern::permute_columns(utilities::intern::string_column_order(keys, count), keys, payloads...);
+            } else {
+                utilities::intern::RadixSorter<Key, std::remove_pointer_t<decltype(std::data(payloads))>...> sorter(
+                    count, std::data(keys), std::data(payloads)...);
+                sorter.sort(threads);
+            }
+        }, utilities::intern::zip_iterables(zipped));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // parallel_sort - Sorts a random access container in place with comp, like
+    // std::sort but on all cores through a parallel sample sort. Given a zip, the
+    // rows are compared as std::tuples of the zipped values, e.g. lexicographically
+    // by default, and all iterables are rearranged.
+    //      parallel_sort(values);
+    //      parallel_sort(zip{ names, ages }, [](const auto& a, const auto& b) { return std::get<1>(a) < std::get<1>(b); });
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Container, class Compare = std::less<>, class = std::enable_if_t<!std::is_rvalue_reference_v<Container&&>>>
+    void parallel_sort(Container&& container, Compare comp = {}, int64_t threads = utilities::intern::hardware_threads()) {
+        utilities::intern::sample_sort<false>(std::data(container), static_cast<int64_t>(std::size(container)), comp, threads);
+    }
+
+    template<class... Iterables, class Compare = std::less<>>
+    void parallel_sort(zip<Iterables...>&& zipped, Compare comp = {}, int64_t threads = utilities::intern::hardware_threads()) {
+        using utilities::intern::materialize;
+        using Row = decltype(materialize(*zipped));
+        std::vector<Row> rows;
+        for (auto&& row : zipped) { rows.push_back(materialize(row)); }
+        utilities::intern::sample_sort<false>(rows.data(), static_cast<int64_t>(rows.size()), comp, threads);
+
+        utilities::intern::assign_columns(utilities::intern::zip_iterables(zipped), rows,
+                                          std::make_index_sequence<sizeof...(Iterables)>{});
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // sorted - Like Python's sorted: a new sorted std::vector of the iterable's values,
+    // stable, in reverse order if asked. Elements of enumerate and zip become
+    // std::tuples. A key function is called once per element and the keys are kept
+    // in their own array next to the row indices, so comparisons never recompute
+    // them or touch the values. Large inputs are sorted on all cores.
+    //      auto by_age = sorted(people, [](const person& p) { return p.age; });
+    //      auto pairs = sorted(zip{ names, scores }, [](const auto& row) { return std::get<1>(row); }, true);
+    // An rvalue std::vector is sorted in place of a copy.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable>
+    auto sorted(Iterable&& iterable, bool reverse = false) {
+        auto values = utilities::intern::to_vector(std::forward<Iterable>(iterable));
+        const int64_t count = static_cast<int64_t>(values.size());
+        const int64_t threads = utilities::intern::hardware_threads();
+        if constexpr (utilities::intern::kIsStringKey<typename decltype(values)::value_type>) {
+            const auto order = utilities::intern::stable_order(std::vector<std::string_view>(values.begin(), values.end()), reverse);
+            utilities::intern::permute_columns(order, values);
+        } else if (reverse) {
+            utilities::intern::sample_sort<true>(values.data(), count, [](const auto& a, const auto& b) { return b < a; }, threads);
+        } else {
+            utilities::intern::sample_sort<true>(values.data(), count, std::less<>{}, threads);
+        }
+        return values;
+    }
+
+    template<class Iterable, class KeyFunction>
+    auto sorted(Iterable&& iterable, KeyFunction key, bool reverse = false) {
+        auto values = utilities::intern::to_vector(std::forward<Iterable>(iterable));
+        std::vector<std::decay_t<decltype(key(values.front()))>> keys;
+        keys.reserve(values.size());
+        for (const auto& value : values) { keys.push_back(key(value)); }
+
+        decltype(values) result;
+        result.reserve(values.size());
+        for (int64_t index : utilities::intern::stable_order(std::move(keys), reverse)) { result.push_back(std::move(values[index])); }
+        return result;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // argsort - The indices that would sort the iterable, i.e. the indices of
+    // sorted(enumerate{ iterable }, key), stable and optionally reversed. The keys
+    // (or values) are copied once into their own array and sorted with the indices,
+    // radix sorted when they're integers or floating point numbers.
+    // permute - Applies such an order to a container, or to every iterable of a zip:
+    // afterwards element i is the former element order[i]. order must be a
+    // permutation of the rows.
+    //      auto order = argsort(timestamps);
+    //      permute(zip{ timestamps, values, names }, order);
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable>
+    std::vector<int64_t> argsort(Iterable&& iterable, bool reverse = false) {
+        return utilities::intern::stable_order(utilities::intern::to_vector(std::forward<Iterable>(iterable)), reverse);
+    }
+
+    template<class Iterable, class KeyFunction>
+    std::vector<int64_t> argsort(Iterable&& iterable, KeyFunction key, bool reverse = false) {
+        std::vector<std::decay_t<decltype(key(utilities::intern::row_of(*std::begin(iterable))))>> keys;
+        for (auto&& value : iterable) { keys.push_back(key(utilities::intern::row_of(value))); }
+        return utilities::intern::stable_order(std::move(keys), reverse);
+    }
+
+    template<class Container, class = std::enable_if_t<!std::is_rvalue_reference_v<Container&&>>>
+    void permute(Container&& container, const std::vector<int64_t>& order) {
+        utilities::intern::permute_columns(order, container);
+    }
+
+    template<class... Iterables>
+    void permute(zip<Iterables...>&& zipped, const std::vector<int64_t>& order) {
+        std::apply([&order](auto&... columns) { utilities::intern::permute_columns(order, columns...); },
+                   utilities::intern::zip_iterables(zipped));
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#endif
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // Span - A view of contiguous elements. This is std::span where the standard
+    // library has it, otherwise a stand in with the part of its interface used here.
+    ////////////////////////////////////////////////////////////////////////////////
+#if __cplusplus >= 202002L && __has_include(<span>)
+    template<class T>
+    using Span = std::span<T>;
+#else
+    template<class T>
+    class Span {
+    public:
+        constexpr Span() = default;
+        constexpr Span(T* data, std::size_t size) : data_(data), size_(size) { }
+
+        constexpr T* data() const { return data_; }
+        constexpr std::size_t size() const { return size_; }
+        constexpr bool empty() const { return size_ == 0; }
+        constexpr T* begin() const { return data_; }
+        constexpr T* end() const { return data_ + size_; }
+        constexpr T& operator[](std::size_t index) const { return data_[index]; }
+        constexpr T& front() const { return data_[0]; }
+        constexpr T& back() const { return data_[size_ - 1]; }
+        constexpr Span first(std::size_t count) const { return {data_, count}; }
+        constexpr Span subspan(std::size_t offset, std::size_t count) const { return {data_ + offset, count}; }
+
+    private:
+        T* data_ = nullptr;
+        std::size_t size_ = 0;
+    };
+#endif
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ContiguousElement - The element type of an iterable with std::data and std::size,
+    // const if only const access is given, void for any other iterable.
+    // ContiguousValue - The same without const.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable, class = void>
+    struct ContiguousElement {
+        using type = void;
+    };
+
+    template<class Iterable>
+    struct ContiguousElement<Iterable, std::void_t<decltype(std::data(std::declval<Iterable&>())), decltype(std::size(std::declval<Iterable&>()))>> {
+        using type = std::remove_pointer_t<decltype(std::data(std::declval<Iterable&>()))>;
+    };
+
+    template<class Iterable>
+    struct ContiguousValue {
+        using type = std::remove_cv_t<typename ContiguousElement<Iterable>::type>;
+    };
+}
@@ -0,0 +1,577 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "generator_iterator.h"
+#include "parallel.h"
+#include "simd.h"
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // IsContiguousOf - True for containers whose elements are stored contiguously as
+    // T, i.e. std::data yields a pointer to T
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Container, class T, class = void>
+    struct IsContiguousOf : std::false_type {};
+
+    template<class Container, class T>
+    struct IsContiguousOf<Container, T, std::void_t<decltype(std::data(std::declval<Container&>()))>>
+        : std::is_same<std::remove_cv_t<std::remove_pointer_t<decltype(std::data(std::declval<Container&>()))>>, T> {};
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // BlockMoments - Count, mean, sum of squared deviations, min and max of one block
+    // of contiguous doubles. Two passes over the block, which stays in cache: the
+    // first sums and finds the extremes, the second sums the squared deviations from
+    // the block mean. Each pass keeps several vector accumulators going.
+    ////////////////////////////////////////////////////////////////////////////////
+    struct BlockMoments {
+        int64_t count = 0;
+        double mean = 0;
+        double m2 = 0;
+        double min = std::numeric_limits<double>::infinity();
+        double max = -std::numeric_limits<double>::infinity();
+    };
+
+    inline BlockMoments block_moments(const double* values, std::size_t count) {
+        BlockMoments result;
+        if (count == 0) { return result; }
+
+        std::size_t i = 0;
+        double sum = 0;
+#if defined(UTILITIES_HAS_VECTOR_EXTENSIONS)
+        using Lanes = Vector<double, 4>;
+        constexpr std::size_t kLanes = 4;
+        if (count >= 2 * kLanes) {
+            Lanes sum0, sum1, a, b;
+            load(sum0, values);
+            load(sum1, values + kLanes);
+            Lanes low = sum0 < sum1 ? sum0 : sum1, high = sum0 < sum1 ? sum1 : sum0;
+            for (i = 2 * kLanes; i + 2 * kLanes <= count; i += 2 * kLanes) {
+                load(a, values + i);
+                load(b, values + i + kLanes);
+                sum0 += a;
+                sum1 += b;
+                low = a < low ? a : low;
+                low = b < low ? b : low;
+                high = a > high ? a : high;
+                high = b > high ? b : high;
+            }
+            const Lanes total = sum0 + sum1;
+            for (std::size_t lane = 0; lane < kLanes; ++lane) {
+                sum += total[lane];
+                result.min = std::min(result.min, low[lane]);
+                result.max = std::max(result.max, high[lane]);
+            }
+        }
+#endif
+        for (; i < count; ++i) {
+            sum += values[i];
+            result.min = std::min(result.min, values[i]);
+            result.max = std::max(result.max, values[i]);
+        }
+        result.count = static_cast<int64_t>(count);
+        result.mean = sum / count;
+
+        i = 0;
+#if defined(UTILITIES_HAS_VECTOR_EXTENSIONS)
+        if (count >= 2 * kLanes) {
+            const Lanes mean = result.mean - Lanes{};
+            Lanes squares0 = {}, squares1 = {}, a, b;
+            for (; i + 2 * kLanes <= count; i += 2 * kLanes) {
+                load(a, values + i);
+                load(b, values + i + kLanes);
+                a -= mean;
+                b -= mean;
+                squares0 += a * a;
+                squares1 += b * b;
+            }
+            const Lanes total = squares0 + squares1;
+            for (std::size_t lane = 0; lane < kLanes; ++lane) { result.m2 += total[lane]; }
+        }
+#endif
+        for (; i < count; ++i) {
+            const double deviation = values[i] - result.mean;
+            result.m2 += deviation * deviation;
+        }
+        return result;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Selection - Multi rank introselect on contiguous data, the engine behind median,
+    // quantiles, nth and nsmallest.
+    //
+    // partition_less - Moves the values less than pivot to the front and returns their
+    // count. Branch free for arithmetic types, so unpredictable comparisons cost no
+    // mispredictions and the loop runs at a steady few cycles per element.
+    // parallel_partition_less - The same for huge ranges: the chunks are partitioned
+    // on separate threads and then the misplaced spans on either side of the split
+    // are swapped, again in parallel.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class T, class Predicate>
+    int64_t partition_by(T* values, int64_t count, Predicate goes_first) {
+        if constexpr (std::is_arithmetic_v<T>) {
+            int64_t store = 0;
+            for (int64_t i = 0; i < count; ++i) {
+                const T value = values[i];
+                values[i] = values[store];
+                values[store] = value;
+                store += goes_first(value);
+            }
+            return store;
+        } else {
+            return std::partition(values, values + count, goes_first) - values;
+        }
+    }
+
+    template<class T>
+    int64_t partition_less(T* values, int64_t count, const T& pivot) {
+        return partition_by(values, count, [&pivot](const T& value) { return value < pivot; });
+    }
+
+    template<class T>
+    int64_t parallel_partition_less(T* values, int64_t count, const T& pivot, int64_t threads) {
+        auto bound = [&](int64_t chunk) { return count * chunk / threads; };
+        std::vector<int64_t> less(threads);
+        parallel_tasks(threads, [&](int64_t chunk) {
+            less[chunk] = partition_less(values + bound(chunk), bound(chunk + 1) - bound(chunk), pivot);
+        }, threads);
+
+        int64_t split = 0;
+        for (int64_t count_less : less) { split += count_less; }
+
+        // Not less values left of the split and less values right of it, equally many
+        struct Span { int64_t first; int64_t count; };
+        std::vector<Span> high, low;
+        int64_t misplaced = 0;
+        for (int64_t chunk = 0; chunk < threads; ++chunk) {
+            const int64_t middle = bound(chunk) + less[chunk];
+            const int64_t high_end = std::min(bound(chunk + 1), split);
+            if (middle < high_end) {
+                high.push_back({middle, high_end - middle});
+                misplaced += high_end - middle;
+            }
+            const int64_t low_begin = std::max(bound(chunk), split);
+            if (low_begin < middle) { low.push_back({low_begin, middle - low_begin}); }
+        }
+
+        // Each task swaps the misplaced pairs [first, last) of the combined spans
+        auto locate = [](const std::vector<Span>& spans, int64_t index) {
+            std::size_t span = 0;
+            while (index >= spans[span].count) { index -= spans[span++].count; }
+            return std::pair<std::size_t, int64_t>{span, index};
+        };
+        parallel_tasks(threads, [&](int64_t task) {
+            const int64_t first = misplaced * task / threads, last = misplaced * (task + 1) / threads;
+            if (first == last) { return; }
+            auto [high_span, high_offset] = locate(high, first);
+            auto [low_span, low_offset] = locate(low, first);
+            for (int64_t pair = first; pair < last; ++pair) {
+                std::swap(values[high[high_span].first + high_offset], values[low[low_span].first + low_offset]);
+                if (++high_offset == high[high_span].count && pair + 1 < last) { ++high_span; high_offset = 0; }
+                if (++low_offset == low[low_span].count && pair + 1 < last) { ++low_span; low_offset = 0; }
+            }
+        }, threads);
+        return split;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // multi_select - Rearranges values[0, count) so that every position in ranks
+    // (sorted, relative to offset) holds the value it would hold if sorted. Each
+    // partition step sends each rank to the side it falls on, so all ranks share the
+    // work of one recursive pass. Pivots are medians of three or nine, and once depth
+    // runs out the range is sorted, which bounds the worst case to O(n log n).
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class T>
+    void multi_select(T* values, int64_t count, const int64_t* ranks, int64_t rank_count, int64_t offset, int depth) {
+        constexpr int64_t kSortBelow = 32;
+        constexpr int64_t kParallelAbove = int64_t{1} << 22;
+        for (;;) {
+            if (rank_count == 0) { return; }
+            if (count <= kSortBelow || depth-- == 0) {
+                std::sort(values, values + count);
+                return;
+            }
+
+            auto median3 = [values](int64_t a, int64_t b, int64_t c) {
+                return std::max(std::min(values[a], values[b]), std::min(std::max(values[a], values[b]), values[c]));
+            };
+            const int64_t step = count / 8;
+            const T pivot = count < 1024
+                ? median3(0, count / 2, count - 1)
+                : std::max(std::min(median3(0, step, 2 * step), median3(3 * step, 4 * step, 5 * step)),
+                           std::min(std::max(median3(0, step, 2 * step), median3(3 * step, 4 * step, 5 * step)),
+                                    median3(6 * step, 7 * step, count - 1)));
+
+            const int64_t threads = count >= kParallelAbove ? hardware_threads() : 1;
+            int64_t split = threads > 1 ? parallel_partition_less(values, count, pivot, threads)
+                                        : partition_less(values, count, pivot);
+            if (split == 0) {
+                // The pivot is the smallest value, split off everything equal to it instead
+                split = partition_by(values, count, [&pivot](const T& value) { return !(pivot < value); });
+                const int64_t* first_right = std::lower_bound(ranks, ranks + rank_count, offset + split);
+                rank_count -= first_right - ranks;
+                ranks = first_right;
+                values += split;
+                count -= split;
+                offset += split;
+                continue;
+            }
+
+            const int64_t* first_right = std::lower_bound(ranks, ranks + rank_count, offset + split);
+            multi_select(values, split, ranks, first_right - ranks, offset, depth);
+            rank_count -= first_right - ranks;
+            ranks = first_right;
+            values += split;
+            count -= split;
+            offset += split;
+        }
+    }
+
+    template<class T>
+    void select_ranks(std::vector<T>& values, std::vector<int64_t> ranks) {
+        std::sort(ranks.begin(), ranks.end());
+        ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+        int depth = 2;
+        for (std::size_t size = values.size(); size > 1; size >>= 1) { depth += 2; }
+        multi_select(values.data(), static_cast<int64_t>(values.size()), ranks.data(),
+                     static_cast<int64_t>(ranks.size()), 0, depth);
+    }
+}
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // running_stats - Streaming count, mean, variance, min and max in O(1) memory.
+    // Single values are added with Welford's update, contiguous doubles block wise
+    // through a vectorized kernel. Accumulators of separate parts of the data, e.g.
+    // one per thread, combine exactly with merge (Chan et al.'s formula):
+    //      running_stats stats;
+    //      stats.add(latencies);
+    //      stats.merge(other_thread_stats);
+    //      std::cout << stats.mean() << " +- " << stats.stdev();
+    ////////////////////////////////////////////////////////////////////////////////
+    class running_stats {
+    public:
+        //------------------------------------------------------------------------------
+        // add - Adds one value, or every value of an iterable
+        //------------------------------------------------------------------------------
+        void add(double value) {
+            ++count_;
+            const double deviation = value - mean_;
+            mean_ += deviation / count_;
+            m2_ += deviation * (value - mean_);
+            min_ = std::min(min_, value);
+            max_ = std::max(max_, value);
+        }
+
+        template<class Iterable, class = std::enable_if_t<!std::is_arithmetic_v<std::decay_t<Iterable>>>>
+        void add(Iterable&& values) {
+            if constexpr (utilities::intern::IsContiguousOf<std::remove_reference_t<Iterable>, double>::value) {
+                add(std::data(values), std::size(values));
+            } else {
+                for (auto&& value : values) { add(static_cast<double>(value)); }
+            }
+        }
+
+        void add(const double* values, std::size_t count) {
+            constexpr std::size_t kBlock = 2048;  // 16kB, stays in L1 between the two passes
+            for (std::size_t first = 0; first < count; first += kBlock) {
+                const auto block = utilities::intern::block_moments(values + first, std::min(kBlock, count - first));
+                merge(block.count, block.mean, block.m2, block.min, block.max);
+            }
+        }
+
+        //------------------------------------------------------------------------------
+        // merge - Combines with the statistics of other values, as if they were added
+        //------------------------------------------------------------------------------
+        running_stats& merge(const running_stats& other) {
+            merge(other.count_, other.mean_, other.m2_, other.min_, other.max_);
+            return *this;
+        }
+
+    public:
+        //------------------------------------------------------------------------------
+        // Results - Named like Python's statistics module
+        // variance/stdev - sample variance and standard deviation, NaN below 2 values
+        // pvariance/pstdev - population variance and standard deviation
+        // min/max - +inf/-inf while empty
+        //------------------------------------------------------------------------------
+        int64_t count() const { return count_; }
+        double mean() const { return count_ > 0 ? mean_ : std::numeric_limits<double>::quiet_NaN(); }
+        double variance() const { return count_ > 1 ? m2_ / (count_ - 1) : std::numeric_limits<double>::quiet_NaN(); }
+        double pvariance() const { return count_ > 0 ? m2_ / count_ : std::numeric_limits<double>::quiet_NaN(); }
+        double stdev() const { return std::sqrt(variance()); }
+        double pstdev() const { return std::sqrt(pvariance()); }
+        double min() const { return min_; }
+        double max() const { return max_; }
+
+    private:
+        void merge(int64_t count, double mean, double m2, double min, double max) {
+            if (count == 0) { return; }
+            const int64_t total = count_ + count;
+            const double delta = mean - mean_;
+            mean_ += delta * count / total;
+            m2_ += m2 + delta * delta * (static_cast<double>(count_) * count / total);
+            count_ = total;
+            min_ = std::min(min_, min);
+            max_ = std::max(max_, max);
+        }
+
+        int64_t count_ = 0;
+        double mean_ = 0;
+        double m2_ = 0;
+        double min_ = std::numeric_limits<double>::infinity();
+        double max_ = -std::numeric_limits<double>::infinity();
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // tdigest - Streaming quantile sketch (Dunning's merging t-digest). Values are
+    // summarized by at most about compression centroids, which are kept small near
+    // the tails, so extreme percentiles like p99.9 stay accurate; memory is
+    // independent of the number of values. Digests of separate parts of the data
+    // combine with merge.
+    //      tdigest digest;
+    //      digest.add(latencies);
+    //      double p99 = digest.quantile(0.99);
+    ////////////////////////////////////////////////////////////////////////////////
+    class tdigest {
+    public:
+        explicit tdigest(double compression = 200)
+            : compression_(compression)
+        {
+            buffer_.reserve(buffer_capacity());
+        }
+
+    public:
+        //------------------------------------------------------------------------------
+        // add - Adds one value, optionally weighted, or every value of an iterable
+        //------------------------------------------------------------------------------
+        void add(double value, double weight = 1) {
+            if (std::isnan(value)) { return; }
+            buffer_.push_back({value, weight});
+            min_ = std::min(min_, value);
+            max_ = std::max(max_, value);
+            if (buffer_.size() >= buffer_capacity()) { compress(); }
+        }
+
+        template<class Iterable, class = std::enable_if_t<!std::is_arithmetic_v<std::decay_t<Iterable>>>>
+        void add(Iterable&& values) {
+            for (auto&& value : values) { add(static_cast<double>(value)); }
+        }
+
+        //------------------------------------------------------------------------------
+        // merge - Adds the centroids of another digest
+        //------------------------------------------------------------------------------
+        tdigest& merge(const tdigest& other) {
+            for (const Centroid& centroid : other.centroids_) { add(centroid.mean, centroid.weight); }
+            for (const Centroid& centroid : other.buffer_) { add(centroid.mean, centroid.weight); }
+            min_ = std::min(min_, other.min_);
+            max_ = std::max(max_, other.max_);
+            return *this;
+        }
+
+    public:
+        //------------------------------------------------------------------------------
+        // Results
+        // quantile - The estimated value below which a fraction q of the values lie,
+        //            interpolated between centroids; exact min and max at q = 0 and 1.
+        //            NaN while empty
+        // count - The total weight added
+        //------------------------------------------------------------------------------
+        double quantile(double q) const {
+            compress();
+            if (centroids_.empty()) { return std::numeric_limits<double>::quiet_NaN(); }
+            if (q <= 0) { return min_; }
+            if (q >= 1) { return max_; }
+
+            const double target = q * total_weight_;
+            const Centroid& first = centroids_.front();
+            const Centroid& last = centroids_.back();
+            if (target < first.weight / 2) { return min_ + (first.mean - min_) * target / (first.weight / 2); }
+            if (target > total_weight_ - last.weight / 2) {
+                return max_ - (max_ - last.mean) * (total_weight_ - target) / (last.weight / 2);
+            }
+
+            double cumulative = first.weight / 2;
+            for (std::size_t i = 0; i + 1 < centroids_.size(); ++i) {
+                const double gap = (centroids_[i].weight + centroids_[i + 1].weight) / 2;
+                if (cumulative + gap >= target) {
+                    const double t = (target - cumulative) / gap;
+                    return centroids_[i].mean + t * (centroids_[i + 1].mean - centroids_[i].mean);
+                }
+                cumulative += gap;
+            }
+            return last.mean;
+        }
+
+        double count() const {
+            double buffered = 0;
+            for (const Centroid& centroid : buffer_) { buffered += centroid.weight; }
+            return total_weight_ + buffered;
+        }
+
+        double min() const { return min_; }
+        double max() const { return max_; }
+
+    private:
+        struct Centroid {
+            double mean;
+            double weight;
+        };
+
+        std::size_t buffer_capacity() const { return static_cast<std::size_t>(compression_) * 5; }
+
+        // The k1 scale function, centroids may span at most one unit of it
+        double scale(double q) const { return compression_ / (2 * 3.14159265358979323846) * std::asin(2 * q - 1); }
+
+        // Merges the buffered values into the centroids
+        void compress() const {
+            if (buffer_.empty()) { return; }
+            buffer_.insert(buffer_.end(), centroids_.begin(), centroids_.end());
+            std::sort(buffer_.begin(), buffer_.end(), [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+
+            double total = 0;
+            for (const Centroid& centroid : buffer_) { total += centroid.weight; }
+
+            centroids_.clear();
+            Centroid current = buffer_.front();
+            double merged_weight = 0;
+            double limit = scale(0) + 1;
+            for (std::size_t i = 1; i < buffer_.size(); ++i) {
+                const Centroid& next = buffer_[i];
+                if (scale((merged_weight + current.weight + next.weight) / total) <= limit) {
+                    current.weight += next.weight;
+                    current.mean += (next.mean - current.mean) * next.weight / current.weight;
+                } else {
+                    merged_weight += current.weight;
+                    limit = scale(merged_weight / total) + 1;
+                    centroids_.push_back(current);
+                    current = next;
+                }
+            }
+            centroids_.push_back(current);
+            total_weight_ = total;
+            buffer_.clear();
+        }
+
+        double compression_;
+        double min_ = std::numeric_limits<double>::infinity();
+        double max_ = -std::numeric_limits<double>::infinity();
+
+        // Compressed lazily, also by the const queries
+        mutable double total_weight_ = 0;
+        mutable std::vector<Centroid> centroids_;
+        mutable std::vector<Centroid> buffer_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Order statistics - Like Python's statistics module, but in linear expected time
+    // through a multi rank introselect instead of sorting. data is any iterable; an
+    // rvalue std::vector is rearranged in place instead of copied:
+    //      double p50 = median(latencies);                 // copies latencies
+    //      auto cuts = quantiles(std::move(latencies), 100);   // percentiles, no copy
+    //
+    // nth - The k-th smallest value, 0 based
+    // median - The middle value, or the mean of the two middle values. Arithmetic only
+    // median_low/median_high - The lower/higher of the two middle values
+    // quantiles - The n - 1 cut points dividing the data into n equally likely
+    //             intervals, interpolated like Python's default exclusive method or
+    //             its inclusive one. All cut points come from one selection pass.
+    // nsmallest/nlargest - The k smallest/largest values, in sorted order
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Data>
+    auto nth(Data&& data, int64_t k) {
+        auto values = utilities::intern::to_vector(std::forward<Data>(data));
+        if (k < 0 || k >= static_cast<int64_t>(values.size())) { throw std::out_of_range("nth: k out of range"); }
+        utilities::intern::select_ranks(values, {k});
+        return values[k];
+    }
+
+    template<class Data>
+    auto median_low(Data&& data) {
+        auto values = utilities::intern::to_vector(std::forward<Data>(data));
+        if (values.empty()) { throw std::invalid_argument("median_low: no median for empty data"); }
+        const int64_t middle = (static_cast<int64_t>(values.size()) - 1) / 2;
+        utilities::intern::select_ranks(values, {middle});
+        return values[middle];
+    }
+
+    template<class Data>
+    auto median_high(Data&& data) {
+        auto values = utilities::intern::to_vector(std::forward<Data>(data));
+        if (values.empty()) { throw std::invalid_argument("median_high: no median for empty data"); }
+        const int64_t middle = static_cast<int64_t>(values.size()) / 2;
+        utilities::intern::select_ranks(values, {middle});
+        return values[middle];
+    }
+
+    template<class Data>
+    double median(Data&& data) {
+        auto values = utilities::intern::to_vector(std::forward<Data>(data));
+        static_assert(std::is_arithmetic_v<typename decltype(values)::value_type>, "median: use median_low or median_high for non arithmetic data");
+        if (values.empty()) { throw std::invalid_argument("median: no median for empty data"); }
+        const int64_t size = static_cast<int64_t>(values.size());
+        utilities::intern::select_ranks(values, {(size - 1) / 2, size / 2});
+        return (static_cast<double>(values[(size - 1) / 2]) + static_cast<double>(values[size / 2])) / 2;
+    }
+
+    enum class quantile_method { exclusive, inclusive };
+
+    template<class Data>
+    std::vector<double> quantiles(Data&& data, int64_t n = 4, quantile_method method = quantile_method::exclusive) {
+        auto values = utilities::intern::to_vector(std::forward<Data>(data));
+        const int64_t size = static_cast<int64_t>(values.size());
+        if (n < 1) { throw std::invalid_argument("quantiles: n must be at least 1"); }
+        if (size < 2) { throw std::invalid_argument("quantiles: must have at least two data points"); }
+
+        // Cut point i interpolates between the values at ranks lower[i] and lower[i] + 1
+        const int64_t m = method == quantile_method::exclusive ? size + 1 : size - 1;
+        std::vector<int64_t> lower, ranks;
+        for (int64_t i = 1; i < n; ++i) {
+            int64_t j = i * m / n;
+            if (method == quantile_method::exclusive) { j = std::min(std::max<int64_t>(j, 1), size - 1) - 1; }
+            lower.push_back(j);
+            ranks.push_back(j);
+            ranks.push_back(std::min(j + 1, size - 1));
+        }
+        utilities::intern::select_ranks(values, ranks);
+
+        std::vector<double> result;
+        for (int64_t i = 1; i < n; ++i) {
+            const int64_t j = lower[i - 1];
+            const int64_t delta = i * m - (method == quantile_method::exclusive ? j + 1 : j) * n;
+            const double below = static_cast<double>(values[j]);
+            const double above = static_cast<double>(values[std::min(j + 1, size - 1)]);
+            result.push_back((below * (n - delta) + above * delta) / n);
+        }
+        return result;
+    }
+
+    template<class Data>
+    auto nsmallest(Data&& data, int64_t k) {
+        auto values = utilities::intern::to_vector(std::forward<Data>(data));
+        k = std::min<int64_t>(std::max<int64_t>(k, 0), values.size());
+        if (k > 0 && k < static_cast<int64_t>(values.size())) { utilities::intern::select_ranks(values, {k - 1}); }
+        values.resize(k);
+        std::sort(values.begin(), values.end());
+        return values;
+    }
+
+    template<class Data>
+    auto nlargest(Data&& data, int64_t k) {
+        auto values = utilities::intern::to_vector(std::forward<Data>(data));
+        const int64_t size = static_cast<int64_t>(values.size());
+        k = std::min<int64_t>(std::max<int64_t>(k, 0), size);
+        if (k > 0 && k < size) { utilities::intern::select_ranks(values, {size - k}); }
+        values.erase(values.begin(), values.begin() + (size - k));
+        std::sort(values.begin(), values.end(), [](const auto& a, const auto& b) { return b < a; });
+        return values;
+    }
+}
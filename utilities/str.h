@@ -0,0 +1,294 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "range.h"
+#include "unique.h"
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // StrBlock - The reference counted characters of a long str, shared by its
+    // copies and slices
+    ////////////////////////////////////////////////////////////////////////////////
+    struct StrBlock {
+        std::atomic<uint32_t> references;
+
+        char* data() { return reinterpret_cast<char*>(this + 1); }
+
+        static StrBlock* create(std::string_view text) {
+            void* memory = std::malloc(sizeof(StrBlock) + text.size());
+            if (memory == nullptr) { throw std::bad_alloc(); }
+            StrBlock* block = new (memory) StrBlock{{1}};
+            std::memcpy(block->data(), text.data(), text.size());
+            return block;
+        }
+
+        void retain() { references.fetch_add(1, std::memory_order_relaxed); }
+
+        void release() {
+            if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                this->~StrBlock();
+                std::free(this);
+            }
+        }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // SplitImpl - The implementation of str::split, it keeps a copy of the string,
+    // which for long strings shares its characters. A template only so that it can
+    // be named inside str.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Str>
+    class SplitImpl {
+    public:
+        SplitImpl(const Str& source, std::string_view separator)
+            : source_(source)
+            , separator_(separator)
+        {
+            if (separator_.empty() && separator.data() != nullptr) { throw std::invalid_argument("split needs a non-empty separator"); }
+            operator++();
+        }
+
+        const Str& operator*() { return current_; }
+
+        SplitImpl& operator++() {
+            const std::string_view text = source_.view();
+            if (separator_.empty()) {
+                const auto is_space = [](char c) { return c == ' ' || (c >= '\t' && c <= '\r'); };
+                while (position_ < text.size() && is_space(text[position_])) { ++position_; }
+                if (position_ == text.size()) {
+                    done_ = true;
+                    return *this;
+                }
+                std::size_t last = position_;
+                while (last < text.size() && !is_space(text[last])) { ++last; }
+                current_ = source_.promote(text.substr(position_, last - position_));
+                position_ = last;
+            } else {
+                if (position_ == std::string_view::npos) {
+                    done_ = true;
+                    return *this;
+                }
+                const std::size_t found = text.find(separator_.view(), position_);
+                current_ = source_.promote(text.substr(position_, found == std::string_view::npos ? std::string_view::npos : found - position_));
+                position_ = found == std::string_view::npos ? found : found + separator_.size();
+            }
+            return *this;
+        }
+
+        explicit operator bool() const { return !done_; }
+
+    private:
+        const Str source_;
+        const Str separator_;
+        Str current_;
+        std::size_t position_ = 0;
+        bool done_ = false;
+    };
+}
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // str - An immutable string made to be the key of hash maps and sets. Strings of
+    // up to 23 characters are stored inline, longer ones in a reference counted block
+    // that copies share, so no copy allocates. The hash is computed on first use
+    // and kept, and equality checks it before comparing characters.
+    //      str key = "user_id";
+    //      std::unordered_map<str, int> counts;
+    //      for (const str& field : line.split(",")) { ++counts[field]; }
+    // slice and split return strs that share the characters of a long string rather
+    // than copying them, promote turns a string_view into such a str.
+    ////////////////////////////////////////////////////////////////////////////////
+    class str {
+    public:
+        static constexpr std::size_t kInlineCapacity = 23;
+
+        //------------------------------------------------------------------------------
+        // Constructors - Copies of long strings share their characters
+        //------------------------------------------------------------------------------
+        str() noexcept { set_inline({}); }
+        str(std::string_view text) {
+            if (text.size() <= kInlineCapacity) {
+                set_inline(text);
+            } else {
+                if (text.size() > UINT32_MAX) { throw std::length_error("str is limited to 4 GiB"); }
+                utilities::intern::StrBlock* block = utilities::intern::StrBlock::create(text);
+                set_long(block->data(), block, text.size());
+            }
+        }
+        str(const char* text) : str(std::string_view(text)) { }
+        str(const std::string& text) : str(std::string_view(text)) { }
+
+        str(const str& other) noexcept : hash_(other.hash_.load(std::memory_order_relaxed)) {
+            std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+            if (!is_inline()) { block()->retain(); }
+        }
+
+        str(str&& other) noexcept : hash_(other.hash_.load(std::memory_order_relaxed)) {
+            std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+            other.set_inline({});
+            other.hash_.store(0, std::memory_order_relaxed);
+        }
+
+        str& operator=(str other) noexcept {
+            swap(other);
+            return *this;
+        }
+
+        ~str() {
+            if (!is_inline()) { block()->release(); }
+        }
+
+        void swap(str& other) noexcept {
+            unsigned char bytes[sizeof(bytes_)];
+            std::memcpy(bytes, bytes_, sizeof(bytes_));
+            std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+            std::memcpy(other.bytes_, bytes, sizeof(bytes_));
+            const uint64_t hash = hash_.load(std::memory_order_relaxed);
+            hash_.store(other.hash_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            other.hash_.store(hash, std::memory_order_relaxed);
+        }
+
+        //------------------------------------------------------------------------------
+        // Access
+        //------------------------------------------------------------------------------
+        const char* data() const {
+            if (is_inline()) { return reinterpret_cast<const char*>(bytes_); }
+            const char* data;
+            std::memcpy(&data, bytes_, sizeof(data));
+            return data;
+        }
+
+        std::size_t size() const {
+            if (is_inline()) { return kInlineCapacity - bytes_[kTag]; }
+            uint32_t size;
+            std::memcpy(&size, bytes_ + kSizeOffset, sizeof(size));
+            return size;
+        }
+
+        bool empty() const { return size() == 0; }
+        std::string_view view() const { return {data(), size()}; }
+        operator std::string_view() const { return view(); }
+        const char* begin() const { return data(); }
+        const char* end() const { return data() + size(); }
+        char operator[](std::size_t index) const { return data()[index]; }
+
+        // Computed on first use, never 0 so that 0 can mean not computed yet
+        uint64_t hash() const {
+            uint64_t hash = hash_.load(std::memory_order_relaxed);
+            if (hash == 0) {
+                const uint64_t key = utilities::intern::hash_key(view());
+                hash = key != 0 ? key : 1;
+                hash_.store(hash, std::memory_order_relaxed);
+            }
+            return hash;
+        }
+
+        //------------------------------------------------------------------------------
+        // slice - Like Python's s[start:stop], negative indices count from the end.
+        // split - Like Python's str.split, on a separator or, without one, on runs of
+        //         whitespace. Yields slices.
+        // promote - part, which must lie within this string, as a str sharing its
+        //           characters
+        //------------------------------------------------------------------------------
+        str slice(int64_t start, int64_t stop = INT64_MAX) const {
+            const int64_t size = static_cast<int64_t>(this->size());
+            start = std::clamp(start < 0 ? start + size : start, int64_t(0), size);
+            stop = std::clamp(stop < 0 ? stop + size : stop, int64_t(0), size);
+            return promote(view().substr(start, std::max(stop - start, int64_t(0))));
+        }
+
+        str promote(std::string_view part) const {
+            if (is_inline() || part.size() <= kInlineCapacity) { return str(part); }
+            str shared;
+            shared.set_long(part.data(), block(), part.size());
+            block()->retain();
+            return shared;
+        }
+
+        utilities::intern::Generator<utilities::intern::SplitImpl<str>> split(std::string_view separator = {} UTILITIES_LOOP_SITE_PARAMS) const {
+            return utilities::intern::Generator<utilities::intern::SplitImpl<str>>{{*this, separator} UTILITIES_LOOP_SITE_ARGS};
+        }
+
+        //------------------------------------------------------------------------------
+        // Comparisons - Hashes that are known and differ settle inequality early
+        //------------------------------------------------------------------------------
+        friend bool operator==(const str& a, const str& b) {
+            if (a.size() != b.size()) { return false; }
+            const uint64_t hash_a = a.hash_.load(std::memory_order_relaxed);
+            const uint64_t hash_b = b.hash_.load(std::memory_order_relaxed);
+            if (hash_a != 0 && hash_b != 0 && hash_a != hash_b) { return false; }
+            return a.data() == b.data() || std::memcmp(a.data(), b.data(), a.size()) == 0;
+        }
+        friend bool operator==(const str& a, std::string_view b) { return a.view() == b; }
+        friend bool operator==(const str& a, const char* b) { return a.view() == b; }
+        friend bool operator==(const str& a, const std::string& b) { return a.view() == b; }
+        friend bool operator==(std::string_view a, const str& b) { return b == a; }
+        friend bool operator==(const char* a, const str& b) { return b == a; }
+        friend bool operator==(const std::string& a, const str& b) { return b == a; }
+        template<class T>
+        friend bool operator!=(const str& a, const T& b) { return !(a == b); }
+        template<class T, class = std::enable_if_t<!std::is_same_v<T, str>>>
+        friend bool operator!=(const T& a, const str& b) { return !(b == a); }
+        friend bool operator<(const str& a, const str& b) { return a.view() < b.view(); }
+
+    private:
+        // The last byte tells the layouts apart: how much inline capacity is unused,
+        // which is 0 and so terminates 23 characters, or kLong
+        static constexpr std::size_t kTag = kInlineCapacity;
+        static constexpr std::size_t kBlockOffset = sizeof(const char*);
+        static constexpr std::size_t kSizeOffset = kBlockOffset + sizeof(utilities::intern::StrBlock*);
+        static constexpr unsigned char kLong = 0xFF;
+
+        bool is_inline() const { return bytes_[kTag] != kLong; }
+
+        utilities::intern::StrBlock* block() const {
+            utilities::intern::StrBlock* block;
+            std::memcpy(&block, bytes_ + kBlockOffset, sizeof(block));
+            return block;
+        }
+
+        void set_inline(std::string_view text) {
+            if (!text.empty()) { std::memcpy(bytes_, text.data(), text.size()); }
+            std::memset(bytes_ + text.size(), 0, kInlineCapacity - text.size());
+            bytes_[kTag] = static_cast<unsigned char>(kInlineCapacity - text.size());
+        }
+
+        // size fits 32 bits, the constructor checks before anything is allocated
+        void set_long(const char* data, utilities::intern::StrBlock* block, std::size_t size) {
+            const auto size32 = static_cast<uint32_t>(size);
+            std::memcpy(bytes_, &data, sizeof(data));
+            std::memcpy(bytes_ + kBlockOffset, &block, sizeof(block));
+            std::memcpy(bytes_ + kSizeOffset, &size32, sizeof(size32));
+            bytes_[kTag] = kLong;
+        }
+
+        alignas(8) unsigned char bytes_[kInlineCapacity + 1];
+        mutable std::atomic<uint64_t> hash_{0};
+    };
+
+    inline std::ostream& operator<<(std::ostream& os, const str& text) {
+        return os << text.view();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// std::hash specialization - The cached hash
+////////////////////////////////////////////////////////////////////////////////
+namespace std {
+    template<>
+    struct hash<str> {
+        std::size_t operator()(const str& text) const { return static_cast<std::size_t>(text.hash()); }
+    };
+}
@@ -0,0 +1,406 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "generator_iterator.h"
+
+namespace utilities::intern {
+    template<class Buffer>
+    class TeeBranch;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // TeeBuffer - The elements shared by the branches of a tee. Each element is
+    // copied once out of the source, into fixed size chunks kept in a ring: a chunk
+    // is recycled for new elements once the slowest branch has moved past it, so
+    // only the stretch between the slowest and the fastest branch is held. The loops
+    // over the branches are reported at the site the tee was created on.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable>
+    class TeeBuffer {
+    public:
+        static constexpr int64_t kChunk = 256;
+        using Value = decltype(materialize(*std::begin(std::declval<Iterable&>())));
+        using Branch = TeeBranch<TeeBuffer>;
+
+        TeeBuffer(Iterable& iterable, int64_t branches UTILITIES_LOOP_SITE_PARAMS)
+            : iter_(std::begin(iterable))
+            , end_(std::end(iterable))
+            , positions_(std::max<int64_t>(branches, 0), 0)
+        {
+            for (int64_t i = 0; i < static_cast<int64_t>(positions_.size()); ++i) { branches_.emplace_back(*this, i UTILITIES_LOOP_SITE_FORWARD); }
+        }
+
+        TeeBuffer(const TeeBuffer&) = delete;
+        TeeBuffer& operator=(const TeeBuffer&) = delete;
+
+        // Whether branch has an element left, pulling one from the source if needed
+        bool available(int64_t branch) {
+            if (positions_[branch] < produced_) { return true; }
+            if (!(iter_ != end_)) { return false; }
+            pull();
+            return true;
+        }
+
+        const Value& current(int64_t branch) const {
+            const int64_t offset = positions_[branch] - first_;
+            return (*chunks_[offset / kChunk])[offset % kChunk];
+        }
+
+        void advance(int64_t branch) {
+            if (++positions_[branch] % kChunk == 0) { release(); }
+        }
+
+        Branch& branch(int64_t index) { return branches_[index]; }
+        std::deque<Branch>& branches() { return branches_; }
+
+    private:
+        void pull() {
+            if (produced_ == first_ + static_cast<int64_t>(chunks_.size()) * kChunk) {
+                if (spare_.empty()) {
+                    chunks_.push_back(std::make_unique<std::vector<Value>>());
+                    chunks_.back()->reserve(kChunk);
+                } else {
+                    chunks_.push_back(std::move(spare_.back()));
+                    spare_.pop_back();
+                }
+            }
+            chunks_.back()->push_back(materialize(*iter_));
+            ++iter_;
+            ++produced_;
+        }
+
+        // Recycles the chunks every branch is done with
+        void release() {
+            const int64_t slowest = *std::min_element(positions_.begin(), positions_.end());
+            while (!chunks_.empty() && slowest - first_ >= kChunk) {
+                chunks_.front()->clear();
+                spare_.push_back(std::move(chunks_.front()));
+                chunks_.pop_front();
+                first_ += kChunk;
+            }
+        }
+
+        decltype(std::begin(std::declval<Iterable&>())) iter_;
+        decltype(std::end(std::declval<Iterable&>())) end_;
+        std::deque<std::unique_ptr<std::vector<Value>>> chunks_;
+        std::vector<std::unique_ptr<std::vector<Value>>> spare_;
+        std::vector<int64_t> positions_;
+        std::deque<Branch> branches_;
+        int64_t first_ = 0;
+        int64_t produced_ = 0;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // TeeBranch - One of the generators of a tee, yields every element of the source
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Buffer>
+    class TeeBranch {
+    public:
+        TeeBranch(Buffer& buffer, int64_t index UTILITIES_LOOP_SITE_PARAMS)
+            : buffer_(buffer)
+            , index_(index)
+            UTILITIES_LOOP_PROBE_FROM(loop_site)
+        {
+            // Nothing
+        }
+
+        TeeBranch(const TeeBranch&) = delete;
+        TeeBranch(TeeBranch&&) = delete;
+        TeeBranch& operator=(const TeeBranch&) = delete;
+        TeeBranch& operator=(TeeBranch&&) = delete;
+
+    public:
+        //------------------------------------------------------------------------------
+        // Begin and End - Enables usage in ranged-for
+        //------------------------------------------------------------------------------
+        using Iterator = GeneratorIterator<TeeBranch>;
+        Iterator begin() { return Iterator{*this}; }
+        GeneratorEnd end() { return {}; }
+
+    public:
+        //------------------------------------------------------------------------------
+        // operators - Emulating the generator class's operators
+        //------------------------------------------------------------------------------
+        const typename Buffer::Value& operator*() { return buffer_.current(index_); }
+        TeeBranch& operator++() { buffer_.advance(index_); return *this; }
+        explicit operator bool() const { return buffer_.available(index_); }
+
+    private:
+        Buffer& buffer_;
+        int64_t index_;
+
+    public:
+        //------------------------------------------------------------------------------
+        // Loop probe - Only present when loop instrumentation is enabled
+        //------------------------------------------------------------------------------
+        UTILITIES_LOOP_PROBE
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ConcurrentTeeBuffer - The chunks parallel_tee's producer hands to its consumer
+    // threads. A chunk is dropped once every consumer has taken it and the producer
+    // waits while kMaxChunks are pending, which bounds the memory to what the
+    // slowest consumer hasn't reached yet. Consumers that finish early stop counting.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Value>
+    class ConcurrentTeeBuffer {
+    public:
+        static constexpr int64_t kChunk = 1024;
+        static constexpr std::size_t kMaxChunks = 16;
+        using Chunk = std::vector<Value>;
+
+        explicit ConcurrentTeeBuffer(int64_t consumers)
+            : next_(consumers, 0)
+            , active_(consumers)
+        {
+            // Nothing
+        }
+
+        // Hands a chunk to the consumers, false once none of them is left
+        bool publish(Chunk chunk) {
+            auto shared = std::make_shared<const Chunk>(std::move(chunk));
+            std::unique_lock<std::mutex> lock(mutex_);
+            consumed_.wait(lock, [this]() { return chunks_.size() < kMaxChunks || active_ == 0; });
+            if (active_ == 0) { return false; }
+            chunks_.push_back(std::move(shared));
+            produced_.notify_all();
+            return true;
+        }
+
+        void close() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            produced_.notify_all();
+        }
+
+        // The consumer's next chunk, waiting for the producer; null once all were taken
+        std::shared_ptr<const Chunk> next(int64_t consumer) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            produced_.wait(lock, [&]() { return next_[consumer] < end() || closed_; });
+            if (next_[consumer] == end()) { return nullptr; }
+            std::shared_ptr<const Chunk> chunk = chunks_[next_[consumer]++ - first_];
+            release();
+            return chunk;
+        }
+
+        void finish(int64_t consumer) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            next_[consumer] = std::numeric_limits<int64_t>::max();
+            --active_;
+            release();
+            consumed_.notify_one();
+        }
+
+    private:
+        int64_t end() const { return first_ + static_cast<int64_t>(chunks_.size()); }
+
+        void release() {
+            const int64_t slowest = *std::min_element(next_.begin(), next_.end());
+            bool released = false;
+            for (; first_ < slowest && !chunks_.empty(); ++first_) {
+                chunks_.pop_front();
+                released = true;
+            }
+            if (released) { consumed_.notify_one(); }
+        }
+
+        std::mutex mutex_;
+        std::condition_variable produced_;
+        std::condition_variable consumed_;
+        std::deque<std::shared_ptr<const Chunk>> chunks_;
+        std::vector<int64_t> next_;
+        int64_t first_ = 0;
+        int64_t active_;
+        bool closed_ = false;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ConcurrentTeeBranch - What a parallel_tee consumer iterates, on its own thread
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Value>
+    class ConcurrentTeeBranch {
+    public:
+        ConcurrentTeeBranch(ConcurrentTeeBuffer<Value>& buffer, int64_t index)
+            : buffer_(buffer)
+            , index_(index)
+            , chunk_(buffer.next(index))
+        {
+            // Nothing
+        }
+
+        ~ConcurrentTeeBranch() {
+            chunk_.reset();
+            buffer_.finish(index_);
+        }
+
+        ConcurrentTeeBranch(const ConcurrentTeeBranch&) = delete;
+        ConcurrentTeeBranch(ConcurrentTeeBranch&&) = delete;
+        ConcurrentTeeBranch& operator=(const ConcurrentTeeBranch&) = delete;
+        ConcurrentTeeBranch& operator=(ConcurrentTeeBranch&&) = delete;
+
+    public:
+        //------------------------------------------------------------------------------
+        // Begin and End - Enables usage in ranged-for
+        //------------------------------------------------------------------------------
+        using Iterator = GeneratorIterator<ConcurrentTeeBranch>;
+        Iterator begin() { return Iterator{*this}; }
+        GeneratorEnd end() { return {}; }
+
+    public:
+        //------------------------------------------------------------------------------
+        // operators - Emulating the generator class's operators
+        //------------------------------------------------------------------------------
+        const Value& operator*() { return (*chunk_)[offset_]; }
+        ConcurrentTeeBranch& operator++() {
+            if (++offset_ == chunk_->size()) {
+                chunk_ = buffer_.next(index_);
+                offset_ = 0;
+            }
+            return *this;
+        }
+        explicit operator bool() const { return chunk_ != nullptr; }
+        UTILITIES_LOOP_PROBE
+
+    private:
+        ConcurrentTeeBuffer<Value>& buffer_;
+        int64_t index_;
+        std::shared_ptr<const typename ConcurrentTeeBuffer<Value>::Chunk> chunk_;
+        std::size_t offset_ = 0;
+    };
+
+    template<class Value, class Consumer>
+    std::thread start_consumer(ConcurrentTeeBuffer<Value>& buffer, int64_t index, Consumer& consumer, std::exception_ptr& error) {
+        return std::thread([&buffer, index, &consumer, &error]() {
+            ConcurrentTeeBranch<Value> branch(buffer, index);
+            try {
+                consumer(branch);
+            } catch (...) {
+                error = std::current_exception();
+            }
+        });
+    }
+}
+
+namespace utilities {
+    ////////////////////////////////////////////////////////////////////////////////
+    // tee - Like Python's itertools.tee: n independent generators over one single
+    // pass iterable, e.g. a generator. The elements are copied once into a buffer
+    // shared by all branches, which only holds those the slowest branch hasn't
+    // reached yet. A branch that is never iterated therefore keeps everything.
+    // It lives in utilities and is only brought into the anonymous namespace by a
+    // using declaration, so that utilities::tee names it where plain tee is
+    // ambiguous: <fcntl.h> declares a tee() function when _GNU_SOURCE is defined,
+    // which g++ does by default.
+    //      tee branches{ source, 2 };
+    //      for (auto&& value : branches[0]) { }
+    //      for (auto&& value : branches[1]) { }
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable>
+    class tee {
+    public:
+        //------------------------------------------------------------------------------
+        // Initialization variables - Can only be set via aggregate initialization
+        //------------------------------------------------------------------------------
+        Iterable iterable_;
+        int64_t n_ = 2;
+
+    public:
+        //------------------------------------------------------------------------------
+        // State of the tee - It's public to allow for aggregate initialization of
+        // the above variables, but this should be treated as private.
+        //------------------------------------------------------------------------------
+        using Buffer = utilities::intern::TeeBuffer<std::remove_reference_t<Iterable>>;
+        Buffer buffer_{iterable_, n_};
+
+    public:
+        //------------------------------------------------------------------------------
+        // Implicit Constructors - All Deleted
+        //------------------------------------------------------------------------------
+        tee() = delete;
+        tee(const tee&) = delete;
+        tee(tee&&) = delete;
+        tee& operator=(const tee&) = delete;
+        tee& operator=(tee&&) = delete;
+
+    public:
+        //------------------------------------------------------------------------------
+        // Branch access - operator[] and iteration over the n branches
+        //------------------------------------------------------------------------------
+        typename Buffer::Branch& operator[](int64_t index) { return buffer_.branch(index); }
+        int64_t size() const { return n_; }
+        auto begin() { return buffer_.branches().begin(); }
+        auto end() { return buffer_.branches().end(); }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Deduction guides
+    //      tee{some_iterable}
+    //      tee{some_iterable, n}
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable>
+    tee(Iterable&& iterable) -> tee<decltype(iterable)>;
+
+    template<class Iterable>
+    tee(Iterable&& iterable, int64_t) -> tee<decltype(iterable)>;
+}
+
+namespace {
+    using utilities::tee;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // parallel_tee - Runs every consumer on its own thread, each iterating over its
+    // own branch of one pass over the iterable. The calling thread reads the
+    // iterable and hands the elements over in chunks; it waits when it gets too far
+    // ahead of the slowest consumer. Returns once all consumers are done, rethrowing
+    // the first exception thrown by the iterable or a consumer.
+    //      parallel_tee(source,
+    //                   [&](auto& values) { for (auto&& value : values) { count += 1; } },
+    //                   [&](auto& values) { for (auto&& value : values) { stats.add(value); } });
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable, class... Consumers>
+    void parallel_tee(Iterable&& iterable, Consumers&&... consumers) {
+        using Value = decltype(utilities::intern::materialize(*std::begin(iterable)));
+        using Buffer = utilities::intern::ConcurrentTeeBuffer<Value>;
+        constexpr int64_t kConsumers = sizeof...(Consumers);
+
+        Buffer buffer(kConsumers);
+        std::vector<std::exception_ptr> errors(kConsumers + 1);
+        std::vector<std::thread> threads;
+        int64_t index = 0;
+        ((threads.push_back(utilities::intern::start_consumer(buffer, index, consumers, errors[index + 1])), ++index), ...);
+
+        try {
+            typename Buffer::Chunk chunk;
+            chunk.reserve(Buffer::kChunk);
+            bool consumed = true;
+            for (auto&& value : iterable) {
+                chunk.push_back(utilities::intern::materialize(value));
+                if (static_cast<int64_t>(chunk.size()) == Buffer::kChunk) {
+                    consumed = buffer.publish(std::move(chunk));
+                    if (!consumed) { break; }
+                    chunk = typename Buffer::Chunk();
+                    chunk.reserve(Buffer::kChunk);
+                }
+            }
+            if (consumed && !chunk.empty()) { buffer.publish(std::move(chunk)); }
+        } catch (...) {
+            errors[0] = std::current_exception();
+        }
+        buffer.close();
+
+        for (std::thread& thread : threads) { thread.join(); }
+        for (const std::exception_ptr& error : errors) {
+            if (error) { std::rethrow_exception(error); }
+        }
+    }
+}
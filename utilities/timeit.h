@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define UTILITIES_TIMEIT_HAS_TSC 1
+#endif
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // do_not_optimize - Forces value to be computed and treated as used, so that the
+    // code under measurement isn't optimized away. clobber_memory forces pending
+    // writes to memory to happen.
+    ////////////////////////////////////////////////////////////////////////////////
+#if defined(__GNUC__)
+    template<class T>
+    inline void do_not_optimize(T const& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    template<class T>
+    inline void do_not_optimize(T& value) {
+        asm volatile("" : "+m,r"(value) : : "memory");
+    }
+
+    inline void clobber_memory() {
+        asm volatile("" : : : "memory");
+    }
+#else
+    template<class T>
+    inline void do_not_optimize(T const& value) {
+        static volatile const void* sink;
+        sink = &value;
+    }
+
+    inline void clobber_memory() {
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    }
+#endif
+}
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // TickTimer - The cheapest trustworthy clock available. On x86 with an invariant
+    // TSC that's rdtsc, calibrated once against steady_clock. Everywhere else it's
+    // steady_clock itself, i.e. clock_gettime(CLOCK_MONOTONIC) on Linux.
+    ////////////////////////////////////////////////////////////////////////////////
+    class TickTimer {
+    public:
+        static const TickTimer& instance() {
+            static const TickTimer timer;
+            return timer;
+        }
+
+        uint64_t now() const {
+#if defined(UTILITIES_TIMEIT_HAS_TSC)
+            if (uses_tsc_) { return __rdtsc(); }
+#endif
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        double seconds(uint64_t ticks) const { return ticks * seconds_per_tick_; }
+        bool uses_tsc() const { return uses_tsc_; }
+
+    private:
+        TickTimer() {
+#if defined(UTILITIES_TIMEIT_HAS_TSC)
+            unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+            const bool invariant_tsc = __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8)) != 0;
+            if (invariant_tsc) {
+                auto calibrate = [] {
+                    const auto wall_begin = std::chrono::steady_clock::now();
+                    const uint64_t tsc_begin = __rdtsc();
+                    while (std::chrono::steady_clock::now() - wall_begin < std::chrono::milliseconds(10)) { }
+                    const uint64_t tsc_end = __rdtsc();
+                    const auto wall_end = std::chrono::steady_clock::now();
+                    return std::chrono::duration<double>(wall_end - wall_begin).count() / (tsc_end - tsc_begin);
+                };
+                // The smallest of a few rounds is the one least disturbed by preemption
+                double calibrated = calibrate();
+                for (int round = 0; round < 2; ++round) { calibrated = std::min(calibrated, calibrate()); }
+                seconds_per_tick_ = calibrated;
+                uses_tsc_ = true;
+            }
+#endif
+        }
+
+        bool uses_tsc_ = false;
+        double seconds_per_tick_ = 1e-9;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ScopedCpuPin - Pins the calling thread to the cpu it's currently running on
+    // and restores the previous affinity afterwards. A no-op where unsupported.
+    ////////////////////////////////////////////////////////////////////////////////
+    class ScopedCpuPin {
+    public:
+#if defined(__linux__)
+        ScopedCpuPin() {
+            const int cpu = sched_getcpu();
+            if (cpu < 0 || sched_getaffinity(0, sizeof(previous_), &previous_) != 0) { return; }
+            cpu_set_t pinned;
+            CPU_ZERO(&pinned);
+            CPU_SET(cpu, &pinned);
+            pinned_ = sched_setaffinity(0, sizeof(pinned), &pinned) == 0;
+        }
+
+        ~ScopedCpuPin() {
+            if (pinned_) { sched_setaffinity(0, sizeof(previous_), &previous_); }
+        }
+
+    private:
+        cpu_set_t previous_;
+        bool pinned_ = false;
+#else
+        ScopedCpuPin() = default;
+#endif
+
+    public:
+        ScopedCpuPin(const ScopedCpuPin&) = delete;
+        ScopedCpuPin& operator=(const ScopedCpuPin&) = delete;
+    };
+}
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // timeit_result - Per call timings of every repeat, and robust statistics on them.
+    // All times are in seconds per call of the measured function.
+    // Outliers are the repeats more than 3 scaled MADs away from the median.
+    ////////////////////////////////////////////////////////////////////////////////
+    struct timeit_result {
+        int64_t number = 0;
+        std::vector<double> times;
+        double best = 0;
+        double median = 0;
+        double mad = 0;
+        double mean = 0;
+        int64_t outliers = 0;
+        bool used_tsc = false;
+    };
+
+    inline std::ostream& operator<<(std::ostream& os, const timeit_result& result) {
+        auto scaled = [&os](double seconds) -> std::ostream& {
+            if (seconds < 1e-6) { return os << seconds * 1e9 << " ns"; }
+            if (seconds < 1e-3) { return os << seconds * 1e6 << " us"; }
+            if (seconds < 1)    { return os << seconds * 1e3 << " ms"; }
+            return os << seconds << " s";
+        };
+        os << result.number << " loops, " << result.times.size() << " repeats: median ";
+        scaled(result.median) << " +- ";
+        scaled(result.mad) << " (MAD), best ";
+        scaled(result.best) << ", " << result.outliers << " outliers";
+        return os;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // timeit - Measures fn like Python's timeit. Each of the repeat rounds calls fn
+    // number times; with number 0 it's calibrated like Python's autorange, i.e. the
+    // first of 1, 2, 5, 10, 20, 50, ... that takes at least min_round seconds.
+    // fn is warmed up first and the thread is pinned to its current cpu throughout.
+    //      auto result = timeit([&] { do_not_optimize(work()); });
+    //      REQUIRE(result.median < 2e-6);
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Function>
+    timeit_result timeit(Function&& fn, int64_t number = 0, int64_t repeat = 5, double min_round = 0.2) {
+        const utilities::intern::TickTimer& timer = utilities::intern::TickTimer::instance();
+        utilities::intern::ScopedCpuPin pin;
+
+        auto run = [&](int64_t count) {
+            const uint64_t begin = timer.now();
+            for (int64_t i = 0; i < count; ++i) {
+                fn();
+                clobber_memory();
+            }
+            return timer.seconds(timer.now() - begin);
+        };
+
+        // Warm up caches, branch predictors and the cpu's clock
+        const auto warmup_begin = std::chrono::steady_clock::now();
+        do { run(1); } while (std::chrono::steady_clock::now() - warmup_begin < std::chrono::milliseconds(10));
+
+        if (number <= 0) {
+            for (int64_t base = 1; number <= 0; base *= 10) {
+                for (int64_t multiple : {1, 2, 5}) {
+                    if (run(base * multiple) >= min_round) { number = base * multiple; break; }
+                }
+            }
+        }
+
+        timeit_result result;
+        result.number = number;
+        result.used_tsc = timer.uses_tsc();
+        for (int64_t round = 0; round < std::max<int64_t>(repeat, 1); ++round) {
+            result.times.push_back(run(number) / number);
+        }
+
+        std::vector<double> sorted = result.times;
+        auto median_of = [](std::vector<double>& values) {
+            const std::size_t middle = values.size() / 2;
+            std::nth_element(values.begin(), values.begin() + middle, values.end());
+            double upper = values[middle];
+            if (values.size() % 2 != 0) { return upper; }
+            return (upper + *std::max_element(values.begin(), values.begin() + middle)) / 2;
+        };
+        result.median = median_of(sorted);
+
+        std::vector<double> deviations;
+        for (double time : result.times) { deviations.push_back(std::abs(time - result.median)); }
+        result.mad = median_of(deviations);
+
+        double sum = 0;
+        for (double time : result.times) {
+            sum += time;
+            if (std::abs(time - result.median) > 3 * 1.4826 * result.mad) { ++result.outliers; }
+        }
+        result.mean = sum / result.times.size();
+        result.best = *std::min_element(result.times.begin(), result.times.end());
+        return result;
+    }
+}
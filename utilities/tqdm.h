@@ -0,0 +1,278 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include "generator_iterator.h"
+#include "size_hint.h"
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // progress_bar - A progress display on stderr, redrawn by a background thread.
+    // tqdm creates one per loop, but one can also be shared between threads that
+    // each process part of the same work:
+    //      progress_bar bar{total, "work"};
+    //      // on each thread
+    //      for (int64_t i : tqdm{range(begin, end), bar}) { }
+    ////////////////////////////////////////////////////////////////////////////////
+    class progress_bar {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        //------------------------------------------------------------------------------
+        // Constructor - The total is optional, without it no percentage or ETA is shown
+        //------------------------------------------------------------------------------
+        explicit progress_bar(std::optional<int64_t> total = std::nullopt, const char* desc = nullptr,
+                              std::chrono::milliseconds refresh = std::chrono::milliseconds(100))
+            : total_(total)
+            , desc_(desc)
+            , start_(Clock::now())
+            , renderer_([this, refresh]() { run(refresh); })
+        {
+            // Nothing
+        }
+
+        //------------------------------------------------------------------------------
+        // Destructor - Stops the renderer and draws the final state
+        //------------------------------------------------------------------------------
+        ~progress_bar() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            stop_.notify_one();
+            renderer_.join();
+            render(true);
+        }
+
+        progress_bar(const progress_bar&) = delete;
+        progress_bar(progress_bar&&) = delete;
+        progress_bar& operator=(const progress_bar&) = delete;
+        progress_bar& operator=(progress_bar&&) = delete;
+
+    public:
+        //------------------------------------------------------------------------------
+        // update - Adds n completed iterations, safe to call from any thread
+        //------------------------------------------------------------------------------
+        void update(int64_t n) { count_.fetch_add(n, std::memory_order_relaxed); }
+        int64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+    private:
+        void run(std::chrono::milliseconds refresh) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!stop_.wait_for(lock, refresh, [this]() { return stopping_; })) {
+                render(false);
+            }
+        }
+
+        static void format_time(char* buffer, std::size_t size, double seconds) {
+            auto total = static_cast<int64_t>(seconds);
+            if (total >= 3600) {
+                std::snprintf(buffer, size, "%lld:%02lld:%02lld", static_cast<long long>(total / 3600),
+                              static_cast<long long>(total / 60 % 60), static_cast<long long>(total % 60));
+            } else {
+                std::snprintf(buffer, size, "%02lld:%02lld", static_cast<long long>(total / 60),
+                              static_cast<long long>(total % 60));
+            }
+        }
+
+        void render(bool final) const {
+            const int64_t count = this->count();
+            const double elapsed = std::chrono::duration<double>(Clock::now() - start_).count();
+            const double rate = elapsed > 0 ? count / elapsed : 0.0;
+            const char* desc = desc_ != nullptr ? desc_ : "";
+            const char* separator = desc_ != nullptr ? ": " : "";
+
+            char elapsed_text[32];
+            format_time(elapsed_text, sizeof(elapsed_text), elapsed);
+
+            if (total_ && *total_ > 0) {
+                constexpr int kWidth = 20;
+                const double fraction = std::min(1.0, static_cast<double>(count) / *total_);
+                char bar[kWidth + 1];
+                for (int i = 0; i < kWidth; ++i) { bar[i] = i < static_cast<int>(fraction * kWidth) ? '#' : ' '; }
+                bar[kWidth] = '\0';
+
+                char eta_text[32] = "?";
+                if (rate > 0) { format_time(eta_text, sizeof(eta_text), (*total_ - count) / rate); }
+
+                std::fprintf(stderr, "\r%s%s%3d%%|%s| %lld/%lld [%s<%s, %.2fit/s]", desc, separator,
+                             static_cast<int>(fraction * 100), bar, static_cast<long long>(count),
+                             static_cast<long long>(*total_), elapsed_text, eta_text, rate);
+            } else {
+                std::fprintf(stderr, "\r%s%s%lldit [%s, %.2fit/s]", desc, separator,
+                             static_cast<long long>(count), elapsed_text, rate);
+            }
+            if (final) { std::fputc('\n', stderr); }
+            std::fflush(stderr);
+        }
+
+    private:
+        //------------------------------------------------------------------------------
+        // Member Variables - The renderer is last so it starts after everything else
+        //------------------------------------------------------------------------------
+        const std::optional<int64_t> total_;
+        const char* const desc_;
+        const Clock::time_point start_;
+        std::atomic<int64_t> count_{0};
+        std::mutex mutex_;
+        std::condition_variable stop_;
+        bool stopping_ = false;
+        std::thread renderer_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ProgressTarget - What a tqdm loop reports to. Either a bar of its own, created
+    // once the loop's size is known, or a progress_bar shared with other loops.
+    ////////////////////////////////////////////////////////////////////////////////
+    class ProgressTarget {
+    public:
+        ProgressTarget() = default;
+        ProgressTarget(const char* desc) : desc_(desc) { }
+        ProgressTarget(progress_bar& shared) : bar_(&shared) { }
+
+        progress_bar& bind(std::optional<int64_t> total) {
+            if (bar_ == nullptr) {
+                owned_ = std::make_unique<progress_bar>(total, desc_);
+                bar_ = owned_.get();
+            }
+            return *bar_;
+        }
+
+    private:
+        const char* desc_ = nullptr;
+        progress_bar* bar_ = nullptr;
+        std::unique_ptr<progress_bar> owned_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ProgressCounter - Counts iterations in a plain local member. Only every stride
+    // iterations is the clock read and the count published to the bar. The stride
+    // doubles or halves until the checks are roughly kCheckInterval apart, which
+    // keeps the cost of the clock read and the shared atomic far below 0.1%.
+    ////////////////////////////////////////////////////////////////////////////////
+    class ProgressCounter {
+    public:
+        static constexpr std::chrono::microseconds kCheckInterval{1000};
+
+        explicit ProgressCounter(progress_bar& bar)
+            : bar_(bar)
+            , last_check_(progress_bar::Clock::now())
+        {
+            // Nothing
+        }
+
+        ProgressCounter(const ProgressCounter&) = delete;
+        ProgressCounter& operator=(const ProgressCounter&) = delete;
+
+        ~ProgressCounter() { bar_.update(count_ - published_); }
+
+        void operator++() {
+            if (++count_ == next_check_) { check(); }
+        }
+
+    private:
+        void check() {
+            const auto now = progress_bar::Clock::now();
+            const auto elapsed = now - last_check_;
+            last_check_ = now;
+
+            bar_.update(count_ - published_);
+            published_ = count_;
+
+            if (elapsed < kCheckInterval / 2) { stride_ *= 2; }
+            else if (elapsed > kCheckInterval * 4 && stride_ > 1) { stride_ /= 2; }
+            next_check_ = count_ + stride_;
+        }
+
+        progress_bar& bar_;
+        progress_bar::Clock::time_point last_check_;
+        int64_t count_ = 0;
+        int64_t published_ = 0;
+        int64_t next_check_ = 1;
+        int64_t stride_ = 1;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // tqdm - Wraps an iterable (range, enumerate, zip, containers, ...) and reports
+    // the loop's progress on stderr. The wrapped iterable's values are passed
+    // through unchanged, so structured bindings keep working.
+    //
+    // This class behaves like a Generator, but does not inherit from Generator
+    // for the same reason as enumerate.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable>
+    class tqdm {
+    public:
+        //------------------------------------------------------------------------------
+        // Initialization variables - Can only be set via aggregate initialization
+        // target_ - A description for a bar of its own, or a shared progress_bar
+        //------------------------------------------------------------------------------
+        Iterable iterable_;
+        ProgressTarget target_ = {};
+
+    public:
+        //------------------------------------------------------------------------------
+        // State of the generator - It's public to allow for aggregate initialization of
+        // the above variables, but this should be treated as private.
+        //------------------------------------------------------------------------------
+        ProgressCounter counter_{target_.bind(utilities::intern::size_hint(iterable_))};
+        using UnderlyingIterator = decltype(std::begin(iterable_));
+        UnderlyingIterator iter_ = std::begin(iterable_);
+        using UnderlyingEnd = decltype(std::end(iterable_));
+        UnderlyingEnd end_ = std::end(iterable_);
+        UTILITIES_LOOP_PROBE
+
+    public:
+        //------------------------------------------------------------------------------
+        // Implicit Constructors - All Deleted
+        //------------------------------------------------------------------------------
+        constexpr tqdm() = delete;
+        constexpr tqdm(const tqdm&) = delete;
+        constexpr tqdm(tqdm&&) = delete;
+        constexpr tqdm& operator=(const tqdm&) = delete;
+        constexpr tqdm& operator=(tqdm&&) = delete;
+
+    public:
+        //------------------------------------------------------------------------------
+        // Begin and End - Enables usage in ranged-for
+        //------------------------------------------------------------------------------
+        using Iterator = utilities::intern::GeneratorIterator<tqdm>;
+        constexpr Iterator begin() { return Iterator{*this}; }
+        constexpr utilities::intern::GeneratorEnd end() { return {}; }
+
+    public:
+        //------------------------------------------------------------------------------
+        // operators - Emulating the generator class's operators
+        //------------------------------------------------------------------------------
+        constexpr decltype(auto) operator*() { return *iter_; }
+        constexpr tqdm& operator++() { ++iter_; ++counter_; return *this; }
+        constexpr explicit operator bool() const { return iter_ != end_; }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Deduction guides - lvalues are referenced, temporaries are stored by value.
+    // Temporaries are constructed in place, so generators such as enumerate and zip
+    // don't need to be movable. Binding them to a reference member instead crashes
+    // gcc 12 when they are nested in another aggregate.
+    //      tqdm{some_iterable}
+    //      tqdm{some_iterable, "description"}
+    //      tqdm{some_iterable, shared_progress_bar}
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable>
+    tqdm(Iterable&& iterable) -> tqdm<Iterable>;
+
+    template<class Iterable>
+    tqdm(Iterable&& iterable, const char*) -> tqdm<Iterable>;
+
+    template<class Iterable>
+    tqdm(Iterable&& iterable, progress_bar&) -> tqdm<Iterable>;
+}
@@ -0,0 +1,270 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Allocation tracking - Counts heap allocations per thread, so that scopes can
+// report what they allocated and hot loops can be checked to be allocation free.
+//
+// The counting happens in replacement global operator new/delete, which must be
+// defined in exactly one translation unit of the program:
+//      #define UTILITIES_TRACEMALLOC_IMPLEMENTATION
+//      #include "utilities/tracemalloc.h"
+// Without that translation unit nothing is replaced and every scope reports zero,
+// allocation_tracking_enabled() tells the two apart.
+//
+// Every UTILITIES_TRACEMALLOC_SAMPLE_BYTES allocated bytes (per thread) the stack of
+// the allocation that crosses the threshold is captured, 0 disables sampling.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#define UTILITIES_TRACEMALLOC_HAS_BACKTRACE 1
+#endif
+
+#ifndef UTILITIES_TRACEMALLOC_SAMPLE_BYTES
+#define UTILITIES_TRACEMALLOC_SAMPLE_BYTES (1 << 20)
+#endif
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // AllocationSample - The stack of one sampled allocation
+    ////////////////////////////////////////////////////////////////////////////////
+    struct AllocationSample {
+        static constexpr int kMaxFrames = 16;
+
+        std::size_t size = 0;
+        int depth = 0;
+        void* frames[kMaxFrames] = {};
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // AllocationCounters - One thread's counters. Trivially constructible so that the
+    // thread_local needs no initialization guard inside operator new.
+    ////////////////////////////////////////////////////////////////////////////////
+    struct AllocationCounters {
+        static constexpr int kMaxSamples = 16;
+
+        uint64_t allocations;
+        uint64_t deallocations;
+        uint64_t bytes;
+        uint64_t bytes_since_sample;
+        uint64_t samples_taken;
+        AllocationSample samples[kMaxSamples];
+
+        // no_alloc_scope state
+        int no_alloc_depth;
+        int no_alloc_abort_depth;
+        uint64_t no_alloc_violations;
+
+        // Set while the hook itself runs, backtrace() may allocate
+        bool in_hook;
+    };
+
+    inline thread_local AllocationCounters allocation_counters;
+    inline bool allocation_tracking_linked = false;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Hooks called by the replacement operators
+    ////////////////////////////////////////////////////////////////////////////////
+    inline void on_allocation(std::size_t size) {
+        AllocationCounters& counters = allocation_counters;
+        if (counters.in_hook) { return; }
+
+        ++counters.allocations;
+        counters.bytes += size;
+
+        if (counters.no_alloc_depth > 0) {
+            ++counters.no_alloc_violations;
+            if (counters.no_alloc_abort_depth > 0) {
+                counters.in_hook = true;
+                std::fprintf(stderr, "allocation of %zu bytes inside a no_alloc_scope\n", size);
+#if defined(UTILITIES_TRACEMALLOC_HAS_BACKTRACE)
+                void* frames[AllocationSample::kMaxFrames];
+                backtrace_symbols_fd(frames, backtrace(frames, AllocationSample::kMaxFrames), 2);
+#endif
+                std::abort();
+            }
+        }
+
+#if UTILITIES_TRACEMALLOC_SAMPLE_BYTES > 0
+        counters.bytes_since_sample += size;
+        if (counters.bytes_since_sample >= UTILITIES_TRACEMALLOC_SAMPLE_BYTES) {
+            counters.bytes_since_sample %= UTILITIES_TRACEMALLOC_SAMPLE_BYTES;
+            AllocationSample& sample = counters.samples[counters.samples_taken++ % AllocationCounters::kMaxSamples];
+            sample.size = size;
+            sample.depth = 0;
+#if defined(UTILITIES_TRACEMALLOC_HAS_BACKTRACE)
+            counters.in_hook = true;
+            sample.depth = backtrace(sample.frames, AllocationSample::kMaxFrames);
+            counters.in_hook = false;
+#endif
+        }
+#endif
+    }
+
+    inline void on_deallocation(void* ptr) {
+        if (ptr != nullptr && !allocation_counters.in_hook) { ++allocation_counters.deallocations; }
+    }
+}
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // allocation_tracking_enabled - True if the replacement operators are linked in
+    ////////////////////////////////////////////////////////////////////////////////
+    inline bool allocation_tracking_enabled() {
+        return utilities::intern::allocation_tracking_linked;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // allocation_scope - What the current thread allocated since the scope began
+    //      allocation_scope scope;
+    //      for (auto&& [a, b] : zip{ vec1, vec2 }) { ... }
+    //      assert(scope.allocations() == 0);
+    ////////////////////////////////////////////////////////////////////////////////
+    class allocation_scope {
+    public:
+        allocation_scope()
+            : allocations_(utilities::intern::allocation_counters.allocations)
+            , deallocations_(utilities::intern::allocation_counters.deallocations)
+            , bytes_(utilities::intern::allocation_counters.bytes)
+        {
+            // Nothing
+        }
+
+        allocation_scope(const allocation_scope&) = delete;
+        allocation_scope& operator=(const allocation_scope&) = delete;
+
+        uint64_t allocations() const { return utilities::intern::allocation_counters.allocations - allocations_; }
+        uint64_t deallocations() const { return utilities::intern::allocation_counters.deallocations - deallocations_; }
+        uint64_t bytes() const { return utilities::intern::allocation_counters.bytes - bytes_; }
+
+    private:
+        const uint64_t allocations_;
+        const uint64_t deallocations_;
+        const uint64_t bytes_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // no_alloc_scope - Marks a region of the current thread that must not allocate.
+    // In abort mode the first allocation prints its stack and aborts, in count mode
+    // allocations are only counted and can be checked with violations().
+    ////////////////////////////////////////////////////////////////////////////////
+    enum class no_alloc_mode { abort, count };
+
+    class no_alloc_scope {
+    public:
+        explicit no_alloc_scope(no_alloc_mode mode = no_alloc_mode::abort)
+            : mode_(mode)
+            , violations_(utilities::intern::allocation_counters.no_alloc_violations)
+        {
+            ++utilities::intern::allocation_counters.no_alloc_depth;
+            if (mode_ == no_alloc_mode::abort) { ++utilities::intern::allocation_counters.no_alloc_abort_depth; }
+        }
+
+        ~no_alloc_scope() {
+            --utilities::intern::allocation_counters.no_alloc_depth;
+            if (mode_ == no_alloc_mode::abort) { --utilities::intern::allocation_counters.no_alloc_abort_depth; }
+        }
+
+        no_alloc_scope(const no_alloc_scope&) = delete;
+        no_alloc_scope& operator=(const no_alloc_scope&) = delete;
+
+        uint64_t violations() const {
+            return utilities::intern::allocation_counters.no_alloc_violations - violations_;
+        }
+
+    private:
+        const no_alloc_mode mode_;
+        const uint64_t violations_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // dump_allocation_samples - Prints the sampled allocation stacks of the current
+    // thread, most recent last
+    ////////////////////////////////////////////////////////////////////////////////
+    inline void dump_allocation_samples(std::ostream& os = std::cerr) {
+        using utilities::intern::AllocationCounters;
+        AllocationCounters& counters = utilities::intern::allocation_counters;
+        const uint64_t available = counters.samples_taken < AllocationCounters::kMaxSamples
+            ? counters.samples_taken : AllocationCounters::kMaxSamples;
+
+        counters.in_hook = true;  // Formatting allocates, don't let it sample itself
+        os << "allocation samples (" << counters.samples_taken << " taken, " << available << " kept)\n";
+        for (uint64_t i = counters.samples_taken - available; i < counters.samples_taken; ++i) {
+            const auto& sample = counters.samples[i % AllocationCounters::kMaxSamples];
+            os << "  " << sample.size << " bytes\n";
+#if defined(UTILITIES_TRACEMALLOC_HAS_BACKTRACE)
+            if (char** symbols = backtrace_symbols(sample.frames, sample.depth)) {
+                for (int frame = 0; frame < sample.depth; ++frame) { os << "    " << symbols[frame] << "\n"; }
+                std::free(symbols);
+            }
+#endif
+        }
+        os.flush();
+        counters.in_hook = false;
+    }
+}
+
+#if defined(UTILITIES_TRACEMALLOC_IMPLEMENTATION)
+////////////////////////////////////////////////////////////////////////////////
+// Replacement global allocation functions - Only in the one implementation TU
+////////////////////////////////////////////////////////////////////////////////
+namespace utilities::intern {
+    inline void* tracked_allocate(std::size_t size, std::size_t alignment, bool nothrow) {
+        if (size == 0) { size = 1; }
+        for (;;) {
+            void* ptr = nullptr;
+            if (alignment <= alignof(std::max_align_t)) {
+                ptr = std::malloc(size);
+            } else if (posix_memalign(&ptr, alignment, size) != 0) {
+                ptr = nullptr;
+            }
+            if (ptr != nullptr) {
+                on_allocation(size);
+                return ptr;
+            }
+            std::new_handler handler = std::get_new_handler();
+            if (handler == nullptr) {
+                if (nothrow) { return nullptr; }
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    inline void tracked_deallocate(void* ptr) {
+        on_deallocation(ptr);
+        std::free(ptr);
+    }
+
+    inline const bool allocation_tracking_registered = (allocation_tracking_linked = true);
+}
+
+void* operator new(std::size_t size) { return utilities::intern::tracked_allocate(size, 0, false); }
+void* operator new[](std::size_t size) { return utilities::intern::tracked_allocate(size, 0, false); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return utilities::intern::tracked_allocate(size, 0, true); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return utilities::intern::tracked_allocate(size, 0, true); }
+void* operator new(std::size_t size, std::align_val_t align) { return utilities::intern::tracked_allocate(size, static_cast<std::size_t>(align), false); }
+void* operator new[](std::size_t size, std::align_val_t align) { return utilities::intern::tracked_allocate(size, static_cast<std::size_t>(align), false); }
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return utilities::intern::tracked_allocate(size, static_cast<std::size_t>(align), true); }
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return utilities::intern::tracked_allocate(size, static_cast<std::size_t>(align), true); }
+
+void operator delete(void* ptr) noexcept { utilities::intern::tracked_deallocate(ptr); }
+void operator delete[](void* ptr) noexcept { utilities::intern::tracked_deallocate(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { utilities::intern::tracked_deallocate(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { utilities::intern::tracked_deallocate(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { utilities::intern::tracked_deallocate(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { utilities::intern::tracked_deallocate(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { utilities::intern::tracked_deallocate(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { utilities::intern::tracked_deallocate(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { utilities::intern::tracked_deallocate(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { utilities::intern::tracked_deallocate(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { utilities::intern::tracked_deallocate(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { utilities::intern::tracked_deallocate(ptr); }
+#endif
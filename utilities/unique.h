@@ -0,0 +1,450 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "generator_iterator.h"
+#include "random.h"
+#include "simd.h"
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // hash_key - A well mixed 64 bit hash of a key. std::hash is the identity for
+    // integers on common standard libraries, so its result is mixed once more.
+    // Tuples, which keys of zip and enumerate elements become, hash their elements.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class T>
+    struct IsTuple : std::false_type {};
+
+    template<class... Ts>
+    struct IsTuple<std::tuple<Ts...>> : std::true_type {};
+
+    template<class A, class B>
+    struct IsTuple<std::pair<A, B>> : std::true_type {};
+
+    template<class Key>
+    uint64_t hash_key(const Key& key) {
+        uint64_t state = 0;
+        if constexpr (IsTuple<Key>::value) {
+            std::apply([&state](const auto&... elements) { ((state = state * 0x100000001B3ull + hash_key(elements)), ...); }, key);
+        } else {
+            state = static_cast<uint64_t>(std::hash<Key>{}(key));
+        }
+        return splitmix64(state);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Identity - The default key function
+    // key_view - What a key is looked up by: the states of zip and enumerate are
+    // materialized into tuples, anything else is passed on as is.
+    ////////////////////////////////////////////////////////////////////////////////
+    struct Identity {
+        template<class T>
+        constexpr T&& operator()(T&& value) const { return std::forward<T>(value); }
+    };
+
+    template<class Value>
+    constexpr decltype(auto) key_view(Value&& value) {
+        if constexpr (HasMemberGet<std::decay_t<Value>>::value) {
+            return materialize(value);
+        } else {
+            return std::forward<Value>(value);
+        }
+    }
+
+    template<class Iterable, class KeyFunction>
+    using EverseenKey = std::decay_t<decltype(key_view(std::declval<KeyFunction&>()(*std::begin(std::declval<Iterable&>()))))>;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // FlatSet - An insert only open addressing hash set. Keys live in one array next
+    // to an array of one byte tags holding 7 bits of their hash, so probing rarely
+    // compares keys and there are no per key allocations. Linear probing, grown to
+    // twice the size at 3/4 load.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Key>
+    class FlatSet {
+    public:
+        // Adds key, true if it wasn't in the set yet
+        bool insert(const Key& key) {
+            if (4 * (size_ + 1) > 3 * tags_.size()) { grow(); }
+            const uint64_t hash = hash_key(key);
+            const uint8_t tag = tag_of(hash);
+            for (std::size_t slot = hash & mask_;; slot = (slot + 1) & mask_) {
+                if (tags_[slot] == 0) {
+                    tags_[slot] = tag;
+                    keys_[slot] = key;
+                    ++size_;
+                    return true;
+                }
+                if (tags_[slot] == tag && keys_[slot] == key) { return false; }
+            }
+        }
+
+        std::size_t size() const { return size_; }
+
+    private:
+        static uint8_t tag_of(uint64_t hash) { return static_cast<uint8_t>(0x80 | hash >> 57); }
+
+        void grow() {
+            std::vector<uint8_t> tags(std::max<std::size_t>(16, 2 * tags_.size()), 0);
+            std::vector<Key> keys(tags.size());
+            mask_ = tags.size() - 1;
+            for (std::size_t i = 0; i < tags_.size(); ++i) {
+                if (tags_[i] == 0) { continue; }
+                std::size_t slot = hash_key(keys_[i]) & mask_;
+                while (tags[slot] != 0) { slot = (slot + 1) & mask_; }
+                tags[slot] = tags_[i];
+                keys[slot] = std::move(keys_[i]);
+            }
+            tags_.swap(tags);
+            keys_.swap(keys);
+        }
+
+        std::vector<uint8_t> tags_;
+        std::vector<Key> keys_;
+        std::size_t size_ = 0;
+        std::size_t mask_ = 0;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // EverseenState - The position of unique_everseen, always at an element whose
+    // key hasn't been seen before or at the end
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterator>
+    struct EverseenState {
+        template<class Iterable, class KeyFunction, class Seen>
+        EverseenState(Iterable& iterable, KeyFunction& key, Seen& seen)
+            : iter_(std::begin(iterable))
+        {
+            skip_seen(iterable, key, seen);
+        }
+
+        template<class Iterable, class KeyFunction, class Seen>
+        void skip_seen(Iterable& iterable, KeyFunction& key, Seen& seen) {
+            while (iter_ != std::end(iterable) && !seen.insert(key_view(key(*iter_)))) { ++iter_; }
+        }
+
+        Iterator iter_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // UniqueRunState - The position of unique, at the first element of a run of equal
+    // elements. Forward iterators compare against the run's first element in place,
+    // elements of single pass iterables like generators are copied to compare.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterator, class = void>
+    struct IsForwardIterator : std::false_type {};
+
+    template<class Iterator>
+    struct IsForwardIterator<Iterator, std::void_t<typename std::iterator_traits<Iterator>::iterator_category>>
+        : std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category> {};
+
+    template<class Iterable>
+    class UniqueRunState {
+    public:
+        using Iterator = decltype(std::begin(std::declval<Iterable&>()));
+
+        explicit UniqueRunState(Iterable& iterable)
+            : iter_(std::begin(iterable))
+        {
+            // Nothing
+        }
+
+        decltype(auto) current() { return *iter_; }
+
+        void advance(Iterable& iterable) {
+            if constexpr (IsForwardIterator<Iterator>::value) {
+                const Iterator run = iter_;
+                for (++iter_; iter_ != std::end(iterable) && *iter_ == *run; ++iter_) { }
+            } else {
+                const auto run = materialize(*iter_);
+                for (++iter_; iter_ != std::end(iterable) && materialize(*iter_) == run; ++iter_) { }
+            }
+        }
+
+        bool valid(Iterable& iterable) const { return iter_ != std::end(iterable); }
+
+    private:
+        Iterator iter_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // UniqueBlockState - unique for 32 bit integers (and 64 bit ones on targets with
+    // wide vectors) in contiguous storage. A block of values is compared against
+    // the block shifted by one at once, and the values that differ from their
+    // predecessor are compacted into a buffer without branches.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class T>
+    class UniqueBlockState {
+    public:
+        static constexpr int64_t kBuffer = 256;
+
+        template<class Iterable>
+        explicit UniqueBlockState(Iterable& iterable)
+            : first_(std::data(iterable))
+            , position_(first_)
+            , last_(first_ + std::size(iterable))
+        {
+            refill();
+        }
+
+        const T& current() { return buffer_[index_]; }
+
+        template<class Iterable>
+        void advance(Iterable&) { if (++index_ == filled_) { refill(); } }
+
+        template<class Iterable>
+        bool valid(Iterable&) const { return index_ < filled_; }
+
+    private:
+        void refill() {
+            index_ = 0;
+            filled_ = 0;
+            if (position_ == first_ && position_ != last_) { buffer_[filled_++] = *position_++; }
+
+#ifdef UTILITIES_HAS_VECTOR_EXTENSIONS
+            constexpr int64_t kLanes = kBlockBytes / sizeof(T);
+            while (kBuffer - filled_ >= kLanes && last_ - position_ >= kLanes) {
+                Vector<T, kLanes> values, previous;
+                load(values, position_);
+                load(previous, position_ - 1);
+                const auto changed = values != previous;
+                for (int64_t lane = 0; lane < kLanes; ++lane) {
+                    buffer_[filled_] = position_[lane];
+                    filled_ += changed[lane] != 0;
+                }
+                position_ += kLanes;
+            }
+#endif
+
+            for (; filled_ < kBuffer && position_ != last_; ++position_) {
+                buffer_[filled_] = *position_;
+                filled_ += *position_ != position_[-1];
+            }
+        }
+
+        const T* first_;
+        const T* position_;
+        const T* last_;
+        std::array<T, kBuffer> buffer_;
+        int64_t index_ = 0;
+        int64_t filled_ = 0;
+    };
+
+    template<class Iterable, class = void>
+    struct UniqueStateOf {
+        using type = UniqueRunState<Iterable>;
+    };
+
+    template<class Iterable>
+    struct UniqueStateOf<Iterable, std::enable_if_t<kHasIntegerBlocks<std::remove_cv_t<std::remove_pointer_t<decltype(std::data(std::declval<Iterable&>()))>>>>> {
+        using type = UniqueBlockState<std::remove_cv_t<std::remove_pointer_t<decltype(std::data(std::declval<Iterable&>()))>>>;
+    };
+}
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // bloom_filter - A set that can only tell for sure that a key was never added.
+    // It answers "maybe added" for about false_positive_rate of the keys that
+    // weren't, in return for a few bits per key no matter how large the keys are.
+    // Blocked: all bits of a key lie in one 64 byte cache line.
+    //      bloom_filter seen(10'000'000, 0.001);
+    //      if (seen.insert(user_id)) { /* definitely new */ }
+    ////////////////////////////////////////////////////////////////////////////////
+    class bloom_filter {
+    public:
+        //------------------------------------------------------------------------------
+        // Constructor - Sized for expected_count keys at the given false positive rate
+        //------------------------------------------------------------------------------
+        explicit bloom_filter(int64_t expected_count, double false_positive_rate = 0.01) {
+            if (expected_count <= 0) { throw std::invalid_argument("bloom_filter needs a positive expected count"); }
+            if (!(false_positive_rate > 0 && false_positive_rate < 1)) { throw std::invalid_argument("bloom_filter needs a false positive rate in (0, 1)"); }
+            const double ln2 = 0.6931471805599453;
+            const double bits = -static_cast<double>(expected_count) * std::log(false_positive_rate) / (ln2 * ln2);
+            blocks_ = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(bits / kBlockBits)));
+            hashes_ = std::clamp(static_cast<int>(std::lround(bits / expected_count * ln2)), 1, 16);
+            words_.assign(blocks_ * kBlockWords, 0);
+        }
+
+    public:
+        //------------------------------------------------------------------------------
+        // insert - Adds key, true if it definitely wasn't added before
+        // contains - False if key definitely wasn't added, true if it maybe was
+        //------------------------------------------------------------------------------
+        template<class Key>
+        bool insert(const Key& key) {
+            const uint64_t hash = utilities::intern::hash_key(key);
+            uint64_t* block = words_.data() + block_of(hash);
+            bool added = false;
+            for_each_bit(hash, [&](int bit) {
+                const uint64_t mask = uint64_t{1} << (bit & 63);
+                added |= !(block[bit >> 6] & mask);
+                block[bit >> 6] |= mask;
+            });
+            return added;
+        }
+
+        template<class Key>
+        bool contains(const Key& key) const {
+            const uint64_t hash = utilities::intern::hash_key(key);
+            const uint64_t* block = words_.data() + block_of(hash);
+            bool present = true;
+            for_each_bit(hash, [&](int bit) { present &= (block[bit >> 6] >> (bit & 63)) & 1; });
+            return present;
+        }
+
+    private:
+        static constexpr int kBlockBits = 512;
+        static constexpr int kBlockWords = kBlockBits / 64;
+
+        // The offset of the block of a hash, from its high half
+        uint64_t block_of(uint64_t hash) const { return ((hash >> 32) * blocks_ >> 32) * kBlockWords; }
+
+        // Double hashing over the bits of a block, from the hash's low half
+        template<class Function>
+        void for_each_bit(uint64_t hash, Function function) const {
+            const uint32_t first = static_cast<uint32_t>(hash);
+            const uint32_t step = (first >> 16 | first << 16) | 1;
+            for (int i = 0; i < hashes_; ++i) { function(static_cast<int>((first + i * step) % kBlockBits)); }
+        }
+
+        std::vector<uint64_t> words_;
+        uint64_t blocks_ = 1;
+        int hashes_ = 1;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // unique - Like more_itertools' unique_justseen: yields the first element of every
+    // run of equal elements, so sorted input comes out deduplicated. Lazy, like zip
+    // and enumerate it refers to the iterable. 32 and 64 bit integers in contiguous
+    // storage are compared a SIMD block at a time.
+    //      for (uint64_t id : unique{ sorted_ids }) { }
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable>
+    class unique {
+    public:
+        //------------------------------------------------------------------------------
+        // Initialization variables - Can only be set via aggregate initialization
+        //------------------------------------------------------------------------------
+        Iterable iterable_;
+
+    public:
+        //------------------------------------------------------------------------------
+        // State of the generator - It's public to allow for aggregate initialization of
+        // the above variables, but this should be treated as private.
+        //------------------------------------------------------------------------------
+        using State = typename utilities::intern::UniqueStateOf<Iterable>::type;
+        State state_{iterable_};
+        UTILITIES_LOOP_PROBE
+
+    public:
+        //------------------------------------------------------------------------------
+        // Implicit Constructors - All Deleted
+        //------------------------------------------------------------------------------
+        constexpr unique() = delete;
+        constexpr unique(const unique&) = delete;
+        constexpr unique(unique&&) = delete;
+        constexpr unique& operator=(const unique&) = delete;
+        constexpr unique& operator=(unique&&) = delete;
+
+    public:
+        //------------------------------------------------------------------------------
+        // Begin and End - Enables usage in ranged-for
+        //------------------------------------------------------------------------------
+        using Iterator = utilities::intern::GeneratorIterator<unique>;
+        constexpr Iterator begin() { return Iterator{*this}; }
+        constexpr utilities::intern::GeneratorEnd end() { return {}; }
+
+    public:
+        //------------------------------------------------------------------------------
+        // operators - Emulating the generator class's operators
+        //------------------------------------------------------------------------------
+        constexpr decltype(auto) operator*() { return state_.current(); }
+        constexpr unique& operator++() { state_.advance(iterable_); return *this; }
+        constexpr explicit operator bool() const { return state_.valid(iterable_); }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // unique_everseen - Like more_itertools' unique_everseen: yields the elements whose
+    // key, the element itself by default, wasn't seen before, in order. The keys seen
+    // are kept in a flat open addressing set. Passing a bloom_filter as the seen set
+    // bounds the memory instead, at the cost of dropping a few unseen elements.
+    //      for (auto&& event : unique_everseen{ events }) { }
+    //      for (auto&& event : unique_everseen{ events, [](const event& e) { return e.id; } }) { }
+    //      for (auto&& event : unique_everseen{ events, [](const event& e) { return e.id; }, bloom_filter(1'000'000, 0.001) }) { }
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable,
+             class KeyFunction = utilities::intern::Identity,
+             class Seen = utilities::intern::FlatSet<utilities::intern::EverseenKey<Iterable, KeyFunction>>>
+    class unique_everseen {
+    public:
+        //------------------------------------------------------------------------------
+        // Initialization variables - Can only be set via aggregate initialization
+        //------------------------------------------------------------------------------
+        Iterable iterable_;
+        KeyFunction key_{};
+        Seen seen_{};
+
+    public:
+        //------------------------------------------------------------------------------
+        // State of the generator - It's public to allow for aggregate initialization of
+        // the above variables, but this should be treated as private.
+        //------------------------------------------------------------------------------
+        using State = utilities::intern::EverseenState<decltype(std::begin(iterable_))>;
+        State state_{iterable_, key_, seen_};
+        UTILITIES_LOOP_PROBE
+
+    public:
+        //------------------------------------------------------------------------------
+        // Implicit Constructors - All Deleted
+        //------------------------------------------------------------------------------
+        constexpr unique_everseen() = delete;
+        constexpr unique_everseen(const unique_everseen&) = delete;
+        constexpr unique_everseen(unique_everseen&&) = delete;
+        constexpr unique_everseen& operator=(const unique_everseen&) = delete;
+        constexpr unique_everseen& operator=(unique_everseen&&) = delete;
+
+    public:
+        //------------------------------------------------------------------------------
+        // Begin and End - Enables usage in ranged-for
+        //------------------------------------------------------------------------------
+        using Iterator = utilities::intern::GeneratorIterator<unique_everseen>;
+        constexpr Iterator begin() { return Iterator{*this}; }
+        constexpr utilities::intern::GeneratorEnd end() { return {}; }
+
+    public:
+        //------------------------------------------------------------------------------
+        // operators - Emulating the generator class's operators
+        //------------------------------------------------------------------------------
+        constexpr decltype(auto) operator*() { return *state_.iter_; }
+        constexpr unique_everseen& operator++() { ++state_.iter_; state_.skip_seen(iterable_, key_, seen_); return *this; }
+        constexpr explicit operator bool() const { return state_.iter_ != std::end(iterable_); }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Deduction guides
+    //      unique{some_iterable}
+    //      unique_everseen{some_iterable}
+    //      unique_everseen{some_iterable, key_function}
+    //      unique_everseen{some_iterable, key_function, seen_set}
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Iterable>
+    unique(Iterable&& iterable) -> unique<decltype(iterable)>;
+
+    template<class Iterable>
+    unique_everseen(Iterable&& iterable) -> unique_everseen<decltype(iterable)>;
+
+    template<class Iterable, class KeyFunction>
+    unique_everseen(Iterable&& iterable, KeyFunction) -> unique_everseen<decltype(iterable), KeyFunction>;
+
+    template<class Iterable, class KeyFunction, class Seen>
+    unique_everseen(Iterable&& iterable, KeyFunction, Seen) -> unique_everseen<decltype(iterable), KeyFunction, Seen>;
+}
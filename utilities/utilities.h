@@ -0,0 +1,25 @@
+#pragma once
+
+#include "generator_iterator.h"
+#include "range.h"
+#include "enumerate.h"
+#include "zip.h"
+#include "size_hint.h"
+#include "tqdm.h"
+#include "timeit.h"
+#include "profile.h"
+#include "tracemalloc.h"
+#include "random.h"
+#include "statistics.h"
+#include "sort.h"
+#include "set_operations.h"
+#include "unique.h"
+#include "tee.h"
+#include "reversed.h"
+#include "roundrobin.h"
+#include "batched.h"
+#include "arena.h"
+#include "list.h"
+#include "interned.h"
+#include "str.h"
+#include "walk.h"
@@ -0,0 +1,454 @@
+#pragma once
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "list.h"
+#include "parallel.h"
+#include "range.h"
+#include "str.h"
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#define UTILITIES_WALK_HAS_GETDENTS 1
+#endif
+
+namespace utilities::intern {
+    // How much of a directory one system call reads, thousands of entries
+    constexpr std::size_t kScanBufferBytes = std::size_t(256) << 10;
+
+    // How many scanned directories a parallel walk keeps ready for the consumer
+    constexpr std::size_t kWalkQueueCapacity = 4096;
+
+    inline std::string join_path(std::string_view directory, std::string_view name) {
+        std::string path;
+        path.reserve(directory.size() + 1 + name.size());
+        path.append(directory);
+        if (!path.empty() && path.back() != '/') { path.push_back('/'); }
+        path.append(name);
+        return path;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // DirEntry - One entry of a directory, as scandir yields it. The type comes from
+    // the directory listing itself, only filesystems that don't report it there cost
+    // an lstat, once, on the first query. Symbolic links are reported as such and not
+    // followed. The name refers to the scan buffer and is valid until the next entry.
+    ////////////////////////////////////////////////////////////////////////////////
+    class DirEntry {
+    public:
+        std::string_view name() const { return name_; }
+        std::string path() const { return join_path(*directory_, name_); }
+        uint64_t inode() const { return inode_; }
+
+        bool is_dir() const { return type() == DT_DIR; }
+        bool is_file() const { return type() == DT_REG; }
+        bool is_symlink() const { return type() == DT_LNK; }
+
+        // One of the DT_ constants of <dirent.h>, DT_UNKNOWN only if lstat failed too
+        unsigned char type() const {
+            struct stat status;
+            if (type_ == DT_UNKNOWN && lstat(path().c_str(), &status) == 0) {
+                type_ = S_ISDIR(status.st_mode) ? DT_DIR : S_ISREG(status.st_mode) ? DT_REG : S_ISLNK(status.st_mode) ? DT_LNK
+                      : S_ISFIFO(status.st_mode) ? DT_FIFO : S_ISSOCK(status.st_mode) ? DT_SOCK : S_ISCHR(status.st_mode) ? DT_CHR
+                      : S_ISBLK(status.st_mode) ? DT_BLK : DT_UNKNOWN;
+            }
+            return type_;
+        }
+
+        // Member Variables, set by the directory reader and its owner
+        const std::string* directory_ = nullptr;
+        std::string_view name_;
+        uint64_t inode_ = 0;
+        mutable unsigned char type_ = DT_UNKNOWN;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // DirectoryReader - Reads the entries of an open directory, skipping . and ..
+    // On Linux it calls getdents64 on the opened directory's descriptor directly,
+    // filling the whole buffer per call rather than the few kilobytes readdir asks for.
+    // Only <dirent.h> is used to open it, since <fcntl.h> declares a global tee.
+    ////////////////////////////////////////////////////////////////////////////////
+    class DirectoryReader {
+    public:
+        DirectoryReader(const char* path, std::vector<char>& buffer)
+            : directory_(opendir(path))
+            , buffer_(buffer)
+        {
+            if (directory_ == nullptr) { error_ = errno; }
+        }
+
+        ~DirectoryReader() {
+            if (directory_ != nullptr) { closedir(directory_); }
+        }
+
+        DirectoryReader(const DirectoryReader&) = delete;
+        DirectoryReader& operator=(const DirectoryReader&) = delete;
+
+        bool is_open() const { return directory_ != nullptr; }
+        // The errno of opening or reading the directory, 0 if neither failed
+        int error() const { return error_; }
+
+        // Fills in the name, inode and type of the next entry, false at the end
+        bool next(DirEntry& entry) {
+#if defined(UTILITIES_WALK_HAS_GETDENTS)
+            struct LinuxDirent64 {
+                uint64_t d_ino;
+                int64_t d_off;
+                unsigned short d_reclen;
+                unsigned char d_type;
+                char d_name[1];
+            };
+            for (;;) {
+                if (offset_ == filled_) {
+                    const long bytes = syscall(SYS_getdents64, dirfd(directory_), buffer_.data(), buffer_.size());
+                    if (bytes <= 0) {
+                        if (bytes < 0) { error_ = errno; }
+                        return false;
+                    }
+                    filled_ = static_cast<std::size_t>(bytes);
+                    offset_ = 0;
+                }
+                const auto* dirent = reinterpret_cast<const LinuxDirent64*>(buffer_.data() + offset_);
+                offset_ += dirent->d_reclen;
+                if (!is_dot(dirent->d_name)) {
+                    set(entry, dirent->d_name, dirent->d_ino, dirent->d_type);
+                    return true;
+                }
+            }
+#else
+            for (errno = 0; const dirent* found = readdir(directory_); errno = 0) {
+                if (!is_dot(found->d_name)) {
+                    set(entry, found->d_name, found->d_ino, found->d_type);
+                    return true;
+                }
+            }
+            error_ = errno;
+            return false;
+#endif
+        }
+
+    private:
+        static bool is_dot(const char* name) {
+            return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+        }
+
+        void set(DirEntry& entry, const char* name, uint64_t inode, unsigned char type) const {
+            entry.name_ = std::string_view(name);
+            entry.inode_ = inode;
+            entry.type_ = type;
+        }
+
+        DIR* directory_;
+        std::vector<char>& buffer_;
+        int error_ = 0;
+#if defined(UTILITIES_WALK_HAS_GETDENTS)
+        std::size_t offset_ = 0;
+        std::size_t filled_ = 0;
+#endif
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ScandirImpl - The implementation of scandir
+    ////////////////////////////////////////////////////////////////////////////////
+    class ScandirImpl {
+    public:
+        ScandirImpl(std::string path)
+            : path_(std::move(path))
+            , buffer_(kScanBufferBytes)
+            , reader_(path_.c_str(), buffer_)
+        {
+            current_.directory_ = &path_;
+            if (!reader_.is_open()) { throw std::system_error(reader_.error(), std::generic_category(), "scandir " + path_); }
+            operator++();
+        }
+
+        const DirEntry& operator*() { return current_; }
+
+        ScandirImpl& operator++() {
+            done_ = !reader_.next(current_);
+            if (done_ && reader_.error() != 0) { throw std::system_error(reader_.error(), std::generic_category(), "scandir " + path_); }
+            return *this;
+        }
+
+        explicit operator bool() const { return !done_; }
+
+    private:
+        const std::string path_;
+        std::vector<char> buffer_;
+        DirectoryReader reader_;
+        DirEntry current_;
+        bool done_ = false;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // WalkFrontier - The directories a parallel walk has found but not scanned yet,
+    // shared by its threads. Counting those being scanned too tells when it's done.
+    ////////////////////////////////////////////////////////////////////////////////
+    class WalkFrontier {
+    public:
+        explicit WalkFrontier(std::string root) : directories_{std::move(root)} { }
+
+        // The next directory to scan, false once all are scanned or the walk stopped
+        bool take(std::string& directory) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [&]() { return stopped_ || !directories_.empty() || pending_ == 0; });
+            if (stopped_ || directories_.empty()) { return false; }
+            directory = std::move(directories_.back());
+            directories_.pop_back();
+            return true;
+        }
+
+        // Adds the subdirectories of a directory taken before, which is done then
+        void finish(std::vector<std::string>& children) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_ += static_cast<int64_t>(children.size()) - 1;
+            for (std::string& child : children) { directories_.push_back(std::move(child)); }
+            if (pending_ == 0 || !children.empty()) { ready_.notify_all(); }
+        }
+
+        void stop() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+            ready_.notify_all();
+        }
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable ready_;
+        std::vector<std::string> directories_;
+        int64_t pending_ = 1;
+        bool stopped_ = false;
+    };
+}
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // WalkEntry - One directory of a walk, like the tuples of Python's os.walk.
+    // Supports structured bindings.
+    ////////////////////////////////////////////////////////////////////////////////
+    struct WalkEntry {
+        // Enables structured bindings
+        template<std::size_t N>
+        auto& get() { return std::get<N>(std::tie(dirpath, dirnames, filenames)); }
+        template<std::size_t N>
+        const auto& get() const { return std::get<N>(std::tie(dirpath, dirnames, filenames)); }
+
+        std::string dirpath;
+        list<str> dirnames;
+        list<str> filenames;
+    };
+
+    // Lists directory into entry, false if it can't be read
+    inline bool scan_directory(std::string directory, WalkEntry& entry, std::vector<char>& buffer) {
+        utilities::intern::DirectoryReader reader(directory.c_str(), buffer);
+        if (!reader.is_open()) { return false; }
+        entry.dirpath = std::move(directory);
+        entry.dirnames.clear();
+        entry.filenames.clear();
+        utilities::intern::DirEntry found;
+        found.directory_ = &entry.dirpath;
+        while (reader.next(found)) { (found.is_dir() ? entry.dirnames : entry.filenames).append(str(found.name())); }
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // WalkImpl - The implementation of walk, depth first like os.walk. The
+    // directories still to be scanned are kept on a stack.
+    ////////////////////////////////////////////////////////////////////////////////
+    class WalkImpl {
+    public:
+        WalkImpl(std::string root)
+            : buffer_(utilities::intern::kScanBufferBytes)
+        {
+            pending_.push_back(std::move(root));
+            scan_next();
+        }
+
+        WalkEntry& operator*() { return current_; }
+
+        // Descends into dirnames as they are now, after the loop body had its say
+        WalkImpl& operator++() {
+            for (std::size_t i = current_.dirnames.size(); i-- > 0;) { pending_.push_back(utilities::intern::join_path(current_.dirpath, current_.dirnames[i])); }
+            scan_next();
+            return *this;
+        }
+
+        explicit operator bool() const { return !done_; }
+
+    private:
+        // Directories that can't be read are skipped, like os.walk does without onerror
+        void scan_next() {
+            while (!pending_.empty()) {
+                std::string directory = std::move(pending_.back());
+                pending_.pop_back();
+                if (scan_directory(std::move(directory), current_, buffer_)) { return; }
+            }
+            done_ = true;
+        }
+
+        std::vector<char> buffer_;
+        std::vector<std::string> pending_;
+        WalkEntry current_;
+        bool done_ = false;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ParallelWalkImpl - The implementation of parallel_walk. Worker threads take
+    // directories from the frontier, add their subdirectories to it and queue the
+    // scanned directory for the thread iterating. Leaving the loop early stops the
+    // workers, the first exception one throws is rethrown by the iteration.
+    ////////////////////////////////////////////////////////////////////////////////
+    class ParallelWalkImpl {
+    public:
+        ParallelWalkImpl(std::string root, int64_t threads)
+            : frontier_(std::move(root))
+            , results_(utilities::intern::kWalkQueueCapacity)
+            , driver_([this, threads]() {
+                try {
+                    utilities::intern::parallel_tasks(std::max<int64_t>(threads, 1), [this](int64_t) { crawl(); }, threads);
+                } catch (...) {
+                    error_ = std::current_exception();
+                }
+                results_.close();
+            })
+        {
+            operator++();
+        }
+
+        ~ParallelWalkImpl() {
+            frontier_.stop();
+            results_.close();
+            if (driver_.joinable()) { driver_.join(); }
+        }
+
+        WalkEntry& operator*() { return current_; }
+
+        ParallelWalkImpl& operator++() {
+            if (!results_.pop(current_)) {
+                done_ = true;
+                driver_.join();
+                if (error_) { std::rethrow_exception(error_); }
+            }
+            return *this;
+        }
+
+        explicit operator bool() const { return !done_; }
+
+    private:
+        void crawl() {
+            std::vector<char> buffer(utilities::intern::kScanBufferBytes);
+            std::vector<std::string> children;
+            std::string directory;
+            try {
+                while (frontier_.take(directory)) {
+                    WalkEntry entry;
+                    children.clear();
+                    const bool scanned = scan_directory(std::move(directory), entry, buffer);
+                    if (scanned) {
+                        for (const str& name : entry.dirnames) { children.push_back(utilities::intern::join_path(entry.dirpath, name)); }
+                    }
+                    // Hand out the subdirectories before waiting for room in the queue
+                    frontier_.finish(children);
+                    if (scanned) { results_.push(std::move(entry)); }
+                }
+            } catch (...) {
+                // The directory taken is never finished, the others would wait for it
+                frontier_.stop();
+                throw;
+            }
+        }
+
+        utilities::intern::WalkFrontier frontier_;
+        utilities::intern::ConcurrentQueue<WalkEntry> results_;
+        WalkEntry current_;
+        std::exception_ptr error_;
+        bool done_ = false;
+        std::thread driver_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // scandir - Like Python's os.scandir, yields the entries of a directory, without
+    // . and .., in the order the filesystem lists them. Entry types come from the
+    // listing, so telling directories from files costs no stat.
+    //      for (auto&& entry : scandir("/data")) {
+    //          if (entry.is_file()) { files.push_back(entry.path()); }
+    //      }
+    // Entries are only valid until the next one. Symbolic links are is_symlink(),
+    // never is_dir() or is_file(). Throws std::system_error if the directory can't
+    // be read.
+    ////////////////////////////////////////////////////////////////////////////////
+    inline utilities::intern::Generator<utilities::intern::ScandirImpl> scandir(std::string path UTILITIES_LOOP_SITE_PARAMS) {
+        return utilities::intern::Generator<utilities::intern::ScandirImpl>{{std::move(path)} UTILITIES_LOOP_SITE_ARGS};
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // walk - Like Python's os.walk, yields every directory of a tree top down, with
+    // the names of its subdirectories and of everything else in it.
+    //      for (auto&& [dirpath, dirnames, filenames] : walk("/data")) {
+    //          dirnames.clear();    // like os.walk, doesn't descend any further
+    //      }
+    // Symbolic links aren't followed and, unlike os.walk, count as files even if
+    // they point to a directory, so no entry needs a stat. Directories that can't be
+    // read are skipped.
+    ////////////////////////////////////////////////////////////////////////////////
+    inline utilities::intern::Generator<WalkImpl> walk(std::string root UTILITIES_LOOP_SITE_PARAMS) {
+        return utilities::intern::Generator<WalkImpl>{{std::move(root)} UTILITIES_LOOP_SITE_ARGS};
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // parallel_walk - walk with the directories scanned by threads threads, for
+    // trees too large to crawl from one. Yields the same entries on the calling
+    // thread, but in no particular order, and changing dirnames has no effect.
+    //      for (auto&& [index, directory] : enumerate{ parallel_walk("/data") }) {
+    //          files += directory.filenames.size();
+    //      }
+    ////////////////////////////////////////////////////////////////////////////////
+    inline utilities::intern::Generator<ParallelWalkImpl> parallel_walk(std::string root, int64_t threads = utilities::intern::hardware_threads() UTILITIES_LOOP_SITE_PARAMS) {
+        return utilities::intern::Generator<ParallelWalkImpl>{{std::move(root), threads} UTILITIES_LOOP_SITE_ARGS};
+    }
+}
+
+// Need to do this since array and tuple define tuple_element and tuple_size as a class and a struct
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wmismatched-tags"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// tuple_element and tuple_size specializations for WalkEntry's structured bindings
+////////////////////////////////////////////////////////////////////////////////
+namespace std {
+    template<std::size_t N>
+    struct tuple_element<N, WalkEntry> {
+        using type = std::remove_reference_t<decltype(std::declval<WalkEntry&>().get<N>())>;
+    };
+
+    template<>
+    struct tuple_size<WalkEntry> : std::integral_constant<std::size_t, 3> {
+        // Empty
+    };
+}
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
+
+#endif
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include "generator_iterator.h"
 
@@ -14,6 +19,9 @@ namespace {
     template<size_t IDX, class... Iterables>
     struct ZipState;
 
+    template<class Fill, class... Iterables>
+    struct ZipLongestState;
+
     ////////////////////////////////////////////////////////////////////////////////
     // zip - This class behaves like a Generator, but does not inherit from
     // Generator because of a clang bug related to rvalue reference lifetime
@@ -35,6 +43,7 @@ namespace {
         //------------------------------------------------------------------------------
         using State = ZipState<0, Iterables...>;
         State state_{storage_};
+        UTILITIES_LOOP_PROBE
 
     public:
         //------------------------------------------------------------------------------
@@ -157,6 +166,197 @@ namespace {
         using NextState = ZipState<IDX+1, RemainingIterables...>;
         NextState next_state;
     };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // zip_longest - Like Python's itertools.zip_longest: zips until the longest
+    // iterable is exhausted, yielding fill in place of the elements of the shorter
+    // ones. The elements are read only.
+    //      for (auto&& [time, price, volume] : zip_longest{ 0.0, times, prices, volumes }) { }
+    // When every iterable has a size, the lengths split the loop into phases in which
+    // the same iterables are present: a bulk phase with all of them, then short tail
+    // phases. Only the phase end is checked per step instead of every iterable.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Fill, class... Iterables>
+    class zip_longest {
+    public:
+        //------------------------------------------------------------------------------
+        // Initialization variables - Can only be set via aggregate initialization
+        //------------------------------------------------------------------------------
+        Fill fill_;
+        using Storage = ZipStorage<0, Iterables...>;
+        Storage storage_;
+
+    public:
+        //------------------------------------------------------------------------------
+        // State of the generator - It's public to allow for aggregate initialization of
+        // the above variables, but this should be treated as private.
+        //------------------------------------------------------------------------------
+        using State = ZipLongestState<Fill, Iterables...>;
+        State state_{fill_, storage_};
+        UTILITIES_LOOP_PROBE
+
+    public:
+        //------------------------------------------------------------------------------
+        // Implicit Constructors - All Deleted
+        //------------------------------------------------------------------------------
+        constexpr zip_longest() = delete;
+        constexpr zip_longest(const zip_longest&) = delete;
+        constexpr zip_longest(zip_longest&&) = delete;
+        constexpr zip_longest& operator=(const zip_longest&) = delete;
+        constexpr zip_longest& operator=(zip_longest&&) = delete;
+
+    public:
+        //------------------------------------------------------------------------------
+        // Begin and End - Enables usage in ranged-for
+        //------------------------------------------------------------------------------
+        using Iterator = utilities::intern::GeneratorIterator<zip_longest>;
+        constexpr Iterator begin() { return Iterator{*this}; }
+        constexpr utilities::intern::GeneratorEnd end() { return {}; }
+
+    public:
+        //------------------------------------------------------------------------------
+        // operators - Emulating the generator class's operators
+        //------------------------------------------------------------------------------
+        constexpr State& operator*() { return state_; }
+        constexpr zip_longest& operator++() { ++state_; return *this; }
+        constexpr explicit operator bool() const { return state_.can_advance(); }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Deduction guides
+    //      zip_longest{fill, some_iterable, more_iterables...}
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Fill, class RequiredIterable, class... OptionalIterables>
+    zip_longest(Fill, RequiredIterable&& required_iterable, OptionalIterables&&... optional_iterables)
+        -> zip_longest<Fill, decltype(required_iterable), decltype(optional_iterables)...>;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // zip_storage_at - The ZipStorage holding the IDX-th iterable
+    ////////////////////////////////////////////////////////////////////////////////
+    template<size_t IDX, class Storage>
+    constexpr auto& zip_storage_at(Storage& storage) {
+        if constexpr (IDX == 0) { return storage; }
+        else { return zip_storage_at<IDX - 1>(storage.next_storage); }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // ZipLongestState - This represents the state of the zip_longest generator. A bit
+    // per iterable tells whether it still has elements.
+    ////////////////////////////////////////////////////////////////////////////////
+    template<class Fill, class... Iterables>
+    struct ZipLongestState {
+        static_assert(sizeof...(Iterables) <= 64, "zip_longest supports up to 64 iterables");
+        using Storage = ZipStorage<0, Iterables...>;
+        using Indices = std::index_sequence_for<Iterables...>;
+        static constexpr bool kSized = (utilities::intern::HasSize<Iterables>::value && ...);
+        static constexpr uint64_t kAllPresent = ~uint64_t{0} >> (64 - sizeof...(Iterables));
+
+        // Construct from the zip_longest's fill and storage
+        constexpr ZipLongestState(const Fill& fill, Storage& storage)
+            : ZipLongestState(fill, storage, Indices{})
+        {
+            // Nothing
+        }
+
+        // Increment the iterators that are still present
+        constexpr void operator++() {
+            increment(Indices{});
+            if constexpr (kSized) {
+                if (++index_ == phase_end_) { next_phase(); }
+            } else {
+                present_ = find_present(Indices{});
+            }
+        }
+
+        constexpr bool can_advance() const {
+            if constexpr (kSized) { return index_ < longest_; }
+            else { return present_ != 0; }
+        }
+
+        // Enables structured bindings. While every iterable is present, which is the
+        // whole phase up to the shortest length, the element is returned without
+        // testing its bit.
+        template <std::size_t N>
+        constexpr decltype(auto) get() const {
+            using Element = decltype(true ? *std::get<N>(iterators_) : std::get<N>(fills_));
+            if (present_ == kAllPresent) { return static_cast<Element>(*std::get<N>(iterators_)); }
+            return (present_ >> N & 1) ? *std::get<N>(iterators_) : std::get<N>(fills_);
+        }
+
+        // Member Variables
+        using Iterators = std::tuple<decltype(std::begin(std::declval<Iterables&>()))...>;
+        using Ends = std::tuple<decltype(std::end(std::declval<Iterables&>()))...>;
+        using Fills = std::tuple<std::decay_t<decltype(*std::begin(std::declval<Iterables&>()))>...>;
+        Iterators iterators_;
+        Ends ends_;
+        Fills fills_;
+        uint64_t present_ = 0;
+        int64_t index_ = 0;
+        int64_t phase_end_ = 0;
+        int64_t longest_ = 0;
+        int64_t lengths_[sizeof...(Iterables)] = {};
+
+    private:
+        template<size_t... Is>
+        constexpr ZipLongestState(const Fill& fill, Storage& storage, std::index_sequence<Is...>)
+            : iterators_(std::begin(zip_storage_at<Is>(storage).iterable)...)
+            , ends_(std::end(zip_storage_at<Is>(storage).iterable)...)
+            , fills_(static_cast<std::tuple_element_t<Is, Fills>>(fill)...)
+        {
+            if constexpr (kSized) {
+                ((lengths_[Is] = static_cast<int64_t>(std::size(zip_storage_at<Is>(storage).iterable))), ...);
+                longest_ = std::max({lengths_[Is]...});
+                next_phase();
+            } else {
+                present_ = find_present(Indices{});
+            }
+        }
+
+        template<size_t... Is>
+        constexpr void increment(std::index_sequence<Is...>) {
+            if (present_ == kAllPresent) {
+                (++std::get<Is>(iterators_), ...);
+            } else {
+                ((present_ >> Is & 1 ? void(++std::get<Is>(iterators_)) : void()), ...);
+            }
+        }
+
+        template<size_t... Is>
+        constexpr uint64_t find_present(std::index_sequence<Is...>) const {
+            return ((uint64_t{std::get<Is>(iterators_) != std::get<Is>(ends_)} << Is) | ...);
+        }
+
+        // The iterables longer than index_ are present until the next length ends
+        constexpr void next_phase() {
+            present_ = 0;
+            phase_end_ = longest_;
+            for (size_t i = 0; i < sizeof...(Iterables); ++i) {
+                if (lengths_[i] > index_) {
+                    present_ |= uint64_t{1} << i;
+                    phase_end_ = std::min(phase_end_, lengths_[i]);
+                }
+            }
+        }
+    };
+}
+
+namespace utilities::intern {
+    ////////////////////////////////////////////////////////////////////////////////
+    // zip_iterables - References to the iterables a zip was constructed with
+    ////////////////////////////////////////////////////////////////////////////////
+    template<size_t IDX, class CurrentIterable, class... RemainingIterables>
+    auto zip_iterables(ZipStorage<IDX, CurrentIterable, RemainingIterables...>& storage) {
+        if constexpr (sizeof...(RemainingIterables) == 0) {
+            return std::forward_as_tuple(storage.iterable);
+        } else {
+            return std::tuple_cat(std::forward_as_tuple(storage.iterable), zip_iterables(storage.next_storage));
+        }
+    }
+
+    template<class... Iterables>
+    auto zip_iterables(zip<Iterables...>& zipped) {
+        return zip_iterables(zipped.storage_);
+    }
 }
 
 // Need to do this since array and tuple define tuple_element and tuple_size as a class and a struct
@@ -166,7 +366,7 @@ namespace {
 #endif
 
 ////////////////////////////////////////////////////////////////////////////////
-// tuple_element and tuple_size specializations for EnumerateState's structured bindings
+// tuple_element and tuple_size specializations for ZipState's and ZipLongestState's structured bindings
 ////////////////////////////////////////////////////////////////////////////////
 namespace std {
     template<std::size_t N, class... Iterables>
@@ -178,6 +378,16 @@ namespace std {
     struct tuple_size<ZipState<0, Iterables...>> : std::integral_constant<std::size_t, sizeof...(Iterables)> {
         // Empty
     };
+
+    template<std::size_t N, class Fill, class... Iterables>
+    struct tuple_element<N, ZipLongestState<Fill, Iterables...>> {
+        using type = decltype(std::declval<ZipLongestState<Fill, Iterables...>>().template get<N>());
+    };
+
+    template<class Fill, class... Iterables>
+    struct tuple_size<ZipLongestState<Fill, Iterables...>> : std::integral_constant<std::size_t, sizeof...(Iterables)> {
+        // Empty
+    };
 }
 
 #if defined(__clang__)